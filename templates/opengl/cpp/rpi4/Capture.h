@@ -0,0 +1,253 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+#include <png.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+// Asynchronous frame capture
+//
+// Grab() is called after a frame is drawn and before it is swapped. It
+// queues a glReadPixels into one of a ring of pixel pack buffers and fences
+// it, so the copy runs on the GPU without stalling the pipeline. The buffer
+// filled two frames earlier is mapped at the same time, by which point its
+// fence has normally signaled, so frame N is read back while N+2 is being
+// rendered. Mapped pixels are copied into a pooled buffer and handed to a
+// writer thread that saves raw RGBA or PNG files. When the writer falls
+// behind and the pool is empty the frame is dropped rather than blocking
+// the render loop.
+
+class Capture
+{
+  public:
+    Capture(GLuint, GLuint, const char*, bool);
+    Capture(const Capture&) = delete;
+    Capture& operator=(const Capture&) = delete;
+    ~Capture();
+    void Grab();
+    unsigned long GetFramesWritten();
+    unsigned long GetFramesDropped();
+
+  private:
+    struct Frame
+    {
+      unsigned long number;
+      std::vector<unsigned char>* pixels;
+    };
+
+    void Retrieve(unsigned int);
+    void WriteFrames();
+    bool WriteRaw(const Frame&);
+    bool WritePng(const Frame&);
+
+    static const unsigned int ringSize = 3;
+    static const unsigned int poolSize = 8;
+
+    GLuint width, height;
+    GLsizeiptr frameBytes;
+    std::string outputDir;
+    bool png;
+
+    GLuint pbos[ringSize];
+    GLsync fences[ringSize];
+    unsigned long slotFrame[ringSize];
+    unsigned long frameCount;
+
+    std::vector<unsigned char> pool[poolSize];
+    std::vector<std::vector<unsigned char>*> freeBuffers;
+    std::deque<Frame> pending;
+    std::mutex lock;
+    std::condition_variable ready;
+    std::thread writer;
+    bool stopping;
+    unsigned long framesWritten, framesDropped;
+};
+
+Capture::Capture(GLuint w, GLuint h, const char* dir, bool writePng) :
+  width(w), height(h), frameBytes(GLsizeiptr(w) * h * 4), outputDir(dir), png(writePng),
+  frameCount(0), stopping(false), framesWritten(0), framesDropped(0)
+{
+  glGenBuffers(ringSize, pbos);
+  for(unsigned int i = 0; i < ringSize; i++)
+  {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[i]);
+    glBufferData(GL_PIXEL_PACK_BUFFER, frameBytes, nullptr, GL_STREAM_READ);
+    fences[i] = 0;
+    slotFrame[i] = 0;
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  for(unsigned int i = 0; i < poolSize; i++)
+  {
+    pool[i].resize(frameBytes);
+    freeBuffers.push_back(&pool[i]);
+  }
+
+  writer = std::thread(&Capture::WriteFrames, this);
+}
+
+Capture::~Capture()
+{
+  // drain what is still in flight, oldest first
+  for(unsigned int i = 1; i <= ringSize; i++)
+    Retrieve((frameCount + i) % ringSize);
+
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    stopping = true;
+  }
+  ready.notify_one();
+  writer.join();
+
+  glDeleteBuffers(ringSize, pbos);
+
+  std::cout << "Capture: " << framesWritten << " frames written, "
+            << framesDropped << " dropped." << std::endl;
+}
+
+void Capture::Grab()
+{
+  unsigned int slot = frameCount % ringSize;
+
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[slot]);
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  slotFrame[slot] = frameCount;
+
+  // the next slot in the ring holds the frame from two grabs ago
+  Retrieve((slot + 1) % ringSize);
+  frameCount++;
+}
+
+void Capture::Retrieve(unsigned int slot)
+{
+  if(!fences[slot]) return;
+
+  // normally already signaled, this only waits when the GPU is 2+ frames behind
+  GLenum status = glClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+  glDeleteSync(fences[slot]);
+  fences[slot] = 0;
+
+  std::vector<unsigned char>* pixels = nullptr;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    if(status != GL_WAIT_FAILED && !freeBuffers.empty())
+    {
+      pixels = freeBuffers.back();
+      freeBuffers.pop_back();
+    }
+    else framesDropped++;
+  }
+
+  if(status == GL_WAIT_FAILED)
+    std::cout << "Capture: fence wait failed on frame " << slotFrame[slot] << std::endl;
+
+  if(!pixels) return;
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[slot]);
+  void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameBytes, GL_MAP_READ_BIT);
+  if(mapped)
+  {
+    std::copy(static_cast<unsigned char*>(mapped), static_cast<unsigned char*>(mapped) + frameBytes, pixels->begin());
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    if(mapped) pending.push_back({ slotFrame[slot], pixels });
+    else
+    {
+      freeBuffers.push_back(pixels);
+      framesDropped++;
+    }
+  }
+  if(mapped) ready.notify_one();
+}
+
+void Capture::WriteFrames()
+{
+  std::unique_lock<std::mutex> guard(lock);
+  while(true)
+  {
+    ready.wait(guard, [this] { return stopping || !pending.empty(); });
+    if(pending.empty()) break;
+
+    Frame frame = pending.front();
+    pending.pop_front();
+    guard.unlock();
+
+    bool written = png ? WritePng(frame) : WriteRaw(frame);
+
+    guard.lock();
+    freeBuffers.push_back(frame.pixels);
+    if(written) framesWritten++;
+    else framesDropped++;
+  }
+}
+
+// GL rows start at the bottom of the window, both writers flip them
+
+bool Capture::WriteRaw(const Frame& frame)
+{
+  std::ostringstream name;
+  name << outputDir << "/frame_" << std::setw(6) << std::setfill('0') << frame.number << ".rgba";
+
+  std::ofstream file(name.str(), std::ios::binary);
+  if(!file)
+  {
+    std::cout << "Capture: unable to open " << name.str() << std::endl;
+    return false;
+  }
+
+  GLsizeiptr stride = GLsizeiptr(width) * 4;
+  for(GLuint row = height; row > 0; row--)
+    file.write(reinterpret_cast<const char*>(frame.pixels->data() + (row - 1) * stride), stride);
+
+  return bool(file);
+}
+
+bool Capture::WritePng(const Frame& frame)
+{
+  std::ostringstream name;
+  name << outputDir << "/frame_" << std::setw(6) << std::setfill('0') << frame.number << ".png";
+
+  png_image image = {};
+  image.version = PNG_IMAGE_VERSION;
+  image.width = width;
+  image.height = height;
+  image.format = PNG_FORMAT_RGBA;
+
+  // a negative stride makes libpng walk the rows bottom up
+  if(!png_image_write_to_file(&image, name.str().c_str(), 0, frame.pixels->data(), -png_int_32(width * 4), nullptr))
+  {
+    std::cout << "Capture: unable to write " << name.str() << ": " << image.message << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+unsigned long Capture::GetFramesWritten()
+{
+  std::lock_guard<std::mutex> guard(lock);
+  return framesWritten;
+}
+
+unsigned long Capture::GetFramesDropped()
+{
+  std::lock_guard<std::mutex> guard(lock);
+  return framesDropped;
+}
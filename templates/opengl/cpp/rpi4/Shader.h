@@ -11,18 +11,22 @@ class Shader
 {
   public:
     Shader(const char*, const char*);
+    explicit Shader(const char*);
     Shader(const Shader&) = delete;
     Shader& operator=(const Shader&) = delete;
     ~Shader();
     GLuint GetId();
     GLuint GetAttribLocation(const char*);
+    GLint GetUniformLocation(const char*);
     void Use();
 
   private:
     std::string FileToString(const char*);
     GLuint CompileVertexShader(const char*);
     GLuint CompileFragmentShader(const char*);
+    GLuint CompileComputeShader(const char*);
     GLuint LinkShaderProgram(GLuint, GLuint);
+    GLuint LinkComputeProgram(GLuint);
 
     GLuint id;
     static const unsigned int msgBuf = 512;
@@ -43,6 +47,18 @@ Shader::Shader(const char* vertexShaderFile, const char* fragmentShaderFile) : i
   if(fragmentShader) glDeleteShader(fragmentShader);
 }
 
+// Compute-only program, needs an OpenGL ES 3.1 context
+Shader::Shader(const char* computeShaderFile) : id(0)
+{
+  std::string css = FileToString(computeShaderFile);
+  const char *computeSource = css.c_str();
+
+  GLuint computeShader = CompileComputeShader(computeSource);
+  id = LinkComputeProgram(computeShader);
+
+  if(computeShader) glDeleteShader(computeShader);
+}
+
 Shader::~Shader()
 {
   if(id) glDeleteProgram(id);
@@ -107,6 +123,31 @@ GLuint Shader::CompileFragmentShader(const char* fragmentSource)
   return fragmentShader;
 }
 
+GLuint Shader::CompileComputeShader(const char* computeSource)
+{
+  GLuint computeShader = glCreateShader(GL_COMPUTE_SHADER);
+  if(!computeShader)
+  {
+    std::cout << "Unable to create compute shader." << std::endl;
+    return 0;
+  }
+
+  GLchar msg[msgBuf];
+  GLint success;
+
+  glShaderSource(computeShader, 1, &computeSource, nullptr);
+  glCompileShader(computeShader);
+  glGetShaderiv(computeShader, GL_COMPILE_STATUS, &success);
+  if(!success)
+  {
+    glGetShaderInfoLog(computeShader, msgBuf, nullptr, msg);
+    std::cout << "COMPUTE SHADER FAILED TO COMPILE:\n" << msg << std::endl;
+    return 0;
+  }
+
+  return computeShader;
+}
+
 GLuint Shader::LinkShaderProgram(GLuint vertexShader, GLuint fragmentShader)
 {
   if(!vertexShader)
@@ -146,6 +187,38 @@ GLuint Shader::LinkShaderProgram(GLuint vertexShader, GLuint fragmentShader)
   return shaderProgram;
 }
 
+GLuint Shader::LinkComputeProgram(GLuint computeShader)
+{
+  if(!computeShader)
+  {
+    std::cout << "Invalid compute shader." << std::endl;
+    return 0;
+  }
+
+  GLuint shaderProgram = glCreateProgram();
+  if(!shaderProgram)
+  {
+    std::cout << "Failed to create shader program." << std::endl;
+    return 0;
+  }
+
+  glAttachShader(shaderProgram, computeShader);
+  glLinkProgram(shaderProgram);
+
+  GLchar msg[msgBuf];
+  GLint success;
+
+  glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+  if(!success)
+  {
+    glGetProgramInfoLog(shaderProgram, msgBuf, nullptr, msg);
+    std::cout << "COMPUTE PROGRAM FAILED TO LINK:\n" << msg << std::endl;
+    return 0;
+  }
+
+  return shaderProgram;
+}
+
 GLuint Shader::GetId()
 {
   return id;
@@ -156,6 +229,11 @@ GLuint Shader::GetAttribLocation(const char* attribute)
   return glGetAttribLocation(id, attribute);
 }
 
+GLint Shader::GetUniformLocation(const char* uniform)
+{
+  return glGetUniformLocation(id, uniform);
+}
+
 void Shader::Use()
 {
   glUseProgram(id);
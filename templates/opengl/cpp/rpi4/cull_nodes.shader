@@ -0,0 +1,31 @@
+#version 310 es
+layout (local_size_x = 64) in;
+
+// x, y, lowest zoom shown at, zoom it disappears at
+layout (std430, binding = 0) readonly buffer Nodes { vec4 nodes[]; };
+layout (std430, binding = 1) writeonly buffer Visible { vec2 visible[]; };
+layout (std430, binding = 2) buffer Command
+{
+  uint count;
+  uint instanceCount;
+  uint first;
+  uint reserved;
+} command;
+
+uniform vec4 viewRect; // min x, min y, max x, max y
+uniform float zoom;
+uniform uint total;
+uniform float margin; // half a marker, in map units
+
+void main()
+{
+  uint i = gl_GlobalInvocationID.x;
+  if(i >= total) return;
+
+  vec4 node = nodes[i];
+  if(zoom < node.z || zoom >= node.w) return;
+  if(any(lessThan(node.xy, viewRect.xy - margin)) || any(greaterThan(node.xy, viewRect.zw + margin))) return;
+
+  uint slot = atomicAdd(command.count, 1u);
+  visible[slot] = node.xy;
+}
@@ -0,0 +1,40 @@
+#version 310 es
+layout (local_size_x = 64) in;
+
+struct Segment
+{
+  vec4 ends; // x0, y0, x1, y1
+  vec4 band; // lowest zoom shown at, zoom it disappears at
+};
+
+layout (std430, binding = 0) readonly buffer Segments { Segment segments[]; };
+layout (std430, binding = 1) writeonly buffer Visible { vec2 visible[]; };
+layout (std430, binding = 2) buffer Command
+{
+  uint count;
+  uint instanceCount;
+  uint first;
+  uint reserved;
+} command;
+
+uniform vec4 viewRect; // min x, min y, max x, max y
+uniform float zoom;
+uniform uint total;
+
+void main()
+{
+  uint i = gl_GlobalInvocationID.x;
+  if(i >= total) return;
+
+  Segment segment = segments[i];
+  if(zoom < segment.band.x || zoom >= segment.band.y) return;
+
+  // bounding box of the segment against the view
+  vec2 lo = min(segment.ends.xy, segment.ends.zw);
+  vec2 hi = max(segment.ends.xy, segment.ends.zw);
+  if(any(lessThan(hi, viewRect.xy)) || any(greaterThan(lo, viewRect.zw))) return;
+
+  uint slot = atomicAdd(command.count, 2u);
+  visible[slot] = segment.ends.xy;
+  visible[slot + 1u] = segment.ends.zw;
+}
@@ -0,0 +1,311 @@
+#define GLFW_INCLUDE_ES31
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include "Shader.h"
+
+// Culls a street grid against a moving view, either with compute shaders
+// that fill indirect draw commands (default) or on the CPU with a buffer
+// upload per frame (--cpu). SPACE switches between the two while running.
+// The CPU time spent per frame is printed once a second for each mode.
+
+static const GLuint WIDTH = 480;
+static const GLuint HEIGHT = 360;
+
+// a GRID x GRID street grid, every MAJOR_EVERY'th street is a major one
+static const int GRID = 256;
+static const int MAJOR_EVERY = 8;
+
+// minor streets and their intersections only show up past this zoom
+static const GLfloat MINOR_ZOOM = 4.0f;
+static const GLfloat NO_LIMIT = 1.0e9f;
+
+static const GLuint GROUP_SIZE = 64; // local_size_x in the cull shaders
+static const GLfloat NODE_SIZE = 4.0f; // pixels
+
+struct Node
+{
+  GLfloat x, y, minZoom, maxZoom;
+};
+
+// matches the std430 layout of Segment in cull_segments.shader
+struct Segment
+{
+  GLfloat x0, y0, x1, y1;
+  GLfloat minZoom, maxZoom, pad0, pad1;
+};
+
+// layout glDrawArraysIndirect reads
+struct DrawCommand
+{
+  GLuint count, instanceCount, first, reserved;
+};
+
+inline void InitContext()
+{
+  glfwInit();
+  glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+}
+
+void BuildGrid(std::vector<Node>& nodes, std::vector<Segment>& segments)
+{
+  for(int y = 0; y < GRID; y++)
+  {
+    for(int x = 0; x < GRID; x++)
+    {
+      bool majorRow = y % MAJOR_EVERY == 0;
+      bool majorColumn = x % MAJOR_EVERY == 0;
+      GLfloat fx = x, fy = y;
+
+      nodes.push_back({ fx, fy, majorRow && majorColumn ? 0.0f : MINOR_ZOOM, NO_LIMIT });
+
+      if(x + 1 < GRID)
+        segments.push_back({ fx, fy, fx + 1, fy, majorRow ? 0.0f : MINOR_ZOOM, NO_LIMIT, 0.0f, 0.0f });
+      if(y + 1 < GRID)
+        segments.push_back({ fx, fy, fx, fy + 1, majorColumn ? 0.0f : MINOR_ZOOM, NO_LIMIT, 0.0f, 0.0f });
+    }
+  }
+}
+
+// the view drifts across the grid and zooms in and out so the visible set keeps changing
+void ViewAt(double t, GLfloat viewRect[4], GLfloat& zoom)
+{
+  zoom = 1.0f + 7.5f * (1.0f + std::sin(t * 0.3));
+  GLfloat cx = GRID * (0.5f + 0.35f * std::cos(t * 0.2));
+  GLfloat cy = GRID * (0.5f + 0.35f * std::sin(t * 0.27));
+  GLfloat halfWidth = GRID / zoom * 0.5f;
+  GLfloat halfHeight = halfWidth * HEIGHT / WIDTH;
+
+  viewRect[0] = cx - halfWidth;
+  viewRect[1] = cy - halfHeight;
+  viewRect[2] = cx + halfWidth;
+  viewRect[3] = cy + halfHeight;
+}
+
+GLsizei CullNodesOnCpu(const std::vector<Node>& nodes, const GLfloat viewRect[4], GLfloat zoom, GLfloat margin, std::vector<GLfloat>& visible)
+{
+  visible.clear();
+  for(const Node& n : nodes)
+  {
+    if(zoom < n.minZoom || zoom >= n.maxZoom) continue;
+    if(n.x < viewRect[0] - margin || n.y < viewRect[1] - margin || n.x > viewRect[2] + margin || n.y > viewRect[3] + margin) continue;
+    visible.push_back(n.x);
+    visible.push_back(n.y);
+  }
+  return visible.size() / 2;
+}
+
+GLsizei CullSegmentsOnCpu(const std::vector<Segment>& segments, const GLfloat viewRect[4], GLfloat zoom, std::vector<GLfloat>& visible)
+{
+  visible.clear();
+  for(const Segment& s : segments)
+  {
+    if(zoom < s.minZoom || zoom >= s.maxZoom) continue;
+    if(std::fmax(s.x0, s.x1) < viewRect[0] || std::fmax(s.y0, s.y1) < viewRect[1]) continue;
+    if(std::fmin(s.x0, s.x1) > viewRect[2] || std::fmin(s.y0, s.y1) > viewRect[3]) continue;
+    visible.push_back(s.x0);
+    visible.push_back(s.y0);
+    visible.push_back(s.x1);
+    visible.push_back(s.y1);
+  }
+  return visible.size() / 2;
+}
+
+GLuint CreateBuffer(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+  GLuint buffer;
+  glGenBuffers(1, &buffer);
+  glBindBuffer(target, buffer);
+  glBufferData(target, size, data, usage);
+  glBindBuffer(target, 0);
+  return buffer;
+}
+
+GLuint CreatePointArray(GLuint buffer, GLint posLoc)
+{
+  GLuint vao;
+  glGenVertexArrays(1, &vao);
+  glBindVertexArray(vao);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer);
+  glVertexAttribPointer(posLoc, 2, GL_FLOAT, GL_FALSE, 2*sizeof(GLfloat), (GLvoid*)0);
+  glEnableVertexAttribArray(posLoc);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  return vao;
+}
+
+// uniforms a shader doesn't declare (margin for segments) are silently skipped by GL
+void Cull(Shader* shader, GLuint input, GLuint output, GLuint command, GLuint total, const GLfloat viewRect[4], GLfloat zoom, GLfloat margin)
+{
+  static const DrawCommand reset = { 0, 1, 0, 0 };
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command);
+  glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(reset), &reset);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+  shader->Use();
+  glUniform4fv(shader->GetUniformLocation("viewRect"), 1, viewRect);
+  glUniform1f(shader->GetUniformLocation("zoom"), zoom);
+  glUniform1ui(shader->GetUniformLocation("total"), total);
+  glUniform1f(shader->GetUniformLocation("margin"), margin);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, input);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, output);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, command);
+  glDispatchCompute((total + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+}
+
+int main(int argc, char** argv)
+{
+  bool gpuCulling = !(argc > 1 && !strcmp(argv[1], "--cpu"));
+
+  InitContext();
+  GLFWwindow* window = nullptr;
+  window = glfwCreateWindow(WIDTH, HEIGHT, "GL Culling", nullptr, nullptr);
+  if(!window)
+  {
+    std::cout << "Window unable to be created." << std::endl;
+    return 1;
+  }
+  glfwMakeContextCurrent(window);
+
+  // don't let vsync hide the difference between the two modes
+  glfwSwapInterval(0);
+
+  Shader* mapShader = new Shader("map_vertex.shader", "map_fragment.shader");
+  Shader* cullNodes = new Shader("cull_nodes.shader");
+  Shader* cullSegments = new Shader("cull_segments.shader");
+  if(!mapShader->GetId() || !cullNodes->GetId() || !cullSegments->GetId())
+  {
+    std::cout << "Shader program invalid." << std::endl;
+    return 1;
+  }
+
+  GLint posLoc = mapShader->GetAttribLocation("position");
+  if(posLoc == -1)
+  {
+    std::cout << "Failed to get attribute location." << std::endl;
+    return 1;
+  }
+
+  std::vector<Node> nodes;
+  std::vector<Segment> segments;
+  BuildGrid(nodes, segments);
+  std::cout << nodes.size() << " nodes, " << segments.size() << " segments" << std::endl;
+
+  // uploaded once, the GPU path never touches them from the CPU again
+  GLuint nodeBuffer = CreateBuffer(GL_SHADER_STORAGE_BUFFER, nodes.size() * sizeof(Node), nodes.data(), GL_STATIC_DRAW);
+  GLuint segmentBuffer = CreateBuffer(GL_SHADER_STORAGE_BUFFER, segments.size() * sizeof(Segment), segments.data(), GL_STATIC_DRAW);
+
+  // sized for everything being visible, written by either the compute shaders or the CPU
+  GLuint visibleNodes = CreateBuffer(GL_ARRAY_BUFFER, nodes.size() * 2 * sizeof(GLfloat), nullptr, GL_DYNAMIC_DRAW);
+  GLuint visibleSegments = CreateBuffer(GL_ARRAY_BUFFER, segments.size() * 4 * sizeof(GLfloat), nullptr, GL_DYNAMIC_DRAW);
+
+  GLuint nodeCommand = CreateBuffer(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawCommand), nullptr, GL_DYNAMIC_DRAW);
+  GLuint segmentCommand = CreateBuffer(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawCommand), nullptr, GL_DYNAMIC_DRAW);
+
+  GLuint nodeVao = CreatePointArray(visibleNodes, posLoc);
+  GLuint segmentVao = CreatePointArray(visibleSegments, posLoc);
+
+  std::vector<GLfloat> cpuNodes, cpuSegments;
+  cpuNodes.reserve(nodes.size() * 2);
+  cpuSegments.reserve(segments.size() * 4);
+
+  glClearColor(0.125f, 0.125f, 0.125f, 1.0f);
+  glViewport(0, 0, WIDTH, HEIGHT);
+
+  double reportTime = glfwGetTime();
+  double cpuTime = 0.0;
+  unsigned int frames = 0;
+  bool spaceDown = false;
+
+  while(!glfwWindowShouldClose(window))
+  {
+    glfwPollEvents();
+
+    bool space = glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS;
+    if(space && !spaceDown) gpuCulling = !gpuCulling;
+    spaceDown = space;
+
+    double frameStart = glfwGetTime();
+
+    GLfloat viewRect[4], zoom;
+    ViewAt(frameStart, viewRect, zoom);
+    GLfloat margin = 0.5f * NODE_SIZE * (viewRect[2] - viewRect[0]) / WIDTH;
+
+    GLsizei nodeCount = 0, segmentCount = 0;
+    if(gpuCulling)
+    {
+      Cull(cullNodes, nodeBuffer, visibleNodes, nodeCommand, nodes.size(), viewRect, zoom, margin);
+      Cull(cullSegments, segmentBuffer, visibleSegments, segmentCommand, segments.size(), viewRect, zoom, 0.0f);
+      // the buffer update bit orders the next glBufferSubData (the command reset,
+      // or a CPU-mode upload) after the shader writes
+      glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    }
+    else
+    {
+      nodeCount = CullNodesOnCpu(nodes, viewRect, zoom, margin, cpuNodes);
+      segmentCount = CullSegmentsOnCpu(segments, viewRect, zoom, cpuSegments);
+
+      glBindBuffer(GL_ARRAY_BUFFER, visibleNodes);
+      glBufferSubData(GL_ARRAY_BUFFER, 0, cpuNodes.size() * sizeof(GLfloat), cpuNodes.data());
+      glBindBuffer(GL_ARRAY_BUFFER, visibleSegments);
+      glBufferSubData(GL_ARRAY_BUFFER, 0, cpuSegments.size() * sizeof(GLfloat), cpuSegments.data());
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    glClear(GL_COLOR_BUFFER_BIT);
+    mapShader->Use();
+    glUniform4fv(mapShader->GetUniformLocation("viewRect"), 1, viewRect);
+    glUniform1f(mapShader->GetUniformLocation("pointSize"), NODE_SIZE);
+
+    glUniform4f(mapShader->GetUniformLocation("color"), 0.0f, 0.0f, 1.0f, 1.0f);
+    glBindVertexArray(segmentVao);
+    if(gpuCulling)
+    {
+      glBindBuffer(GL_DRAW_INDIRECT_BUFFER, segmentCommand);
+      glDrawArraysIndirect(GL_LINES, (GLvoid*)0);
+    }
+    else glDrawArrays(GL_LINES, 0, segmentCount);
+
+    glUniform4f(mapShader->GetUniformLocation("color"), 1.0f, 0.0f, 0.25f, 1.0f);
+    glBindVertexArray(nodeVao);
+    if(gpuCulling)
+    {
+      glBindBuffer(GL_DRAW_INDIRECT_BUFFER, nodeCommand);
+      glDrawArraysIndirect(GL_POINTS, (GLvoid*)0);
+    }
+    else glDrawArrays(GL_POINTS, 0, nodeCount);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+
+    cpuTime += glfwGetTime() - frameStart;
+    glfwSwapBuffers(window);
+    frames++;
+
+    double now = glfwGetTime();
+    if(now - reportTime >= 1.0)
+    {
+      std::cout << "culling: " << (gpuCulling ? "gpu" : "cpu")
+                << "\tfps: " << frames / (now - reportTime)
+                << "\tcpu: " << 1000.0 * cpuTime / frames << " ms/frame" << std::endl;
+      reportTime = now;
+      cpuTime = 0.0;
+      frames = 0;
+    }
+  }
+
+  delete mapShader;
+  delete cullNodes;
+  delete cullSegments;
+  glDeleteVertexArrays(1, &nodeVao);
+  glDeleteVertexArrays(1, &segmentVao);
+  GLuint buffers[] = { nodeBuffer, segmentBuffer, visibleNodes, visibleSegments, nodeCommand, segmentCommand };
+  glDeleteBuffers(6, buffers);
+  glfwTerminate();
+
+  return 0;
+}
@@ -1,7 +1,9 @@
 #define GLFW_INCLUDE_ES31
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <cstring>
 #include "Shader.h"
+#include "Capture.h"
 
 static const GLuint WIDTH = 480;
 static const GLuint HEIGHT = 360;
@@ -20,8 +22,19 @@ inline void InitContext()
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
 }
 
-int main() 
+int main(int argc, char** argv)
 {
+  // ./run [--capture DIR] [--png] [--no-vsync]
+  const char* captureDir = nullptr;
+  bool capturePng = false;
+  bool vsync = true;
+  for(int i = 1; i < argc; i++)
+  {
+    if(!strcmp(argv[i], "--capture") && i + 1 < argc) captureDir = argv[++i];
+    else if(!strcmp(argv[i], "--png")) capturePng = true;
+    else if(!strcmp(argv[i], "--no-vsync")) vsync = false;
+  }
+
   InitContext();
   GLFWwindow* window = nullptr;
   window = glfwCreateWindow(WIDTH, HEIGHT, "GL Test", nullptr, nullptr);
@@ -32,6 +45,9 @@ int main()
   }
   glfwMakeContextCurrent(window);
 
+  // when measuring, don't let vsync cap both runs at the refresh rate and hide the capture cost
+  if(!vsync) glfwSwapInterval(0);
+
   Shader* shader = new Shader("vertex.shader", "fragment.shader");
   if(!shader->GetId())
   {
@@ -61,15 +77,47 @@ int main()
 
   glBindBuffer(GL_ARRAY_BUFFER, 0); // unbind
 
+  Capture* capture = nullptr;
+  if(captureDir) capture = new Capture(WIDTH, HEIGHT, captureDir, capturePng);
+
+  // report the frame rate and what capturing costs the render thread
+  double reportTime = glfwGetTime();
+  double grabTime = 0.0;
+  unsigned int frames = 0;
+
   while(!glfwWindowShouldClose(window))
   {
     glfwPollEvents();
     glClear(GL_COLOR_BUFFER_BIT);
     shader->Use();
     glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    if(capture)
+    {
+      double grabStart = glfwGetTime();
+      capture->Grab();
+      grabTime += glfwGetTime() - grabStart;
+    }
+
     glfwSwapBuffers(window);
+    frames++;
+
+    double now = glfwGetTime();
+    if(now - reportTime >= 1.0)
+    {
+      std::cout << "fps: " << frames / (now - reportTime)
+                << "\tcapture: " << (capture ? "on" : "off");
+      if(capture)
+        std::cout << "\tgrab: " << 1000.0 * grabTime / frames << " ms/frame"
+                  << "\tdropped: " << capture->GetFramesDropped();
+      std::cout << std::endl;
+      reportTime = now;
+      grabTime = 0.0;
+      frames = 0;
+    }
   }
 
+  delete capture;
   delete shader;
   glBindVertexArray(0);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -0,0 +1,7 @@
+#version 310 es
+uniform mediump vec4 color;
+out mediump vec4 fragColor;
+void main()
+{
+   fragColor = color;
+}
@@ -0,0 +1,10 @@
+#version 310 es
+layout (location = 0) in vec2 position;
+uniform vec4 viewRect; // min x, min y, max x, max y
+uniform float pointSize;
+void main()
+{
+   vec2 ndc = (position - viewRect.xy) / (viewRect.zw - viewRect.xy) * 2.0 - 1.0;
+   gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+   gl_PointSize = pointSize;
+}
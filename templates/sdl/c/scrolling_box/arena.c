@@ -0,0 +1,85 @@
+#include "arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static size_t alignUp(size_t n) { return (n + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1); }
+
+// the header and its block share a single allocation
+Arena *createArena(size_t size)
+{
+  size_t header = alignUp(sizeof(Arena));
+  Arena *arena = malloc(header + size);
+  if(!arena)
+  {
+    fprintf(stderr, "createArena(%zu) FAILED\n", size);
+    return NULL;
+  }
+
+  arena->base = (uint8_t *)arena + header;
+  arena->size = size;
+  arena->used = 0;
+  arena->allocations = 0;
+  return arena;
+}
+
+void destroyArena(Arena *arena)
+{
+  free(arena);
+}
+
+void *arenaAlloc(size_t size, Arena *arena)
+{
+  size_t start = alignUp(arena->used);
+  if(start > arena->size || size > arena->size - start)
+  {
+    fprintf(stderr, "arenaAlloc(%zu) FAILED: %zu of %zu bytes used\n", size, arena->used, arena->size);
+    return NULL;
+  }
+
+  arena->used = start + size;
+  arena->allocations++;
+  return arena->base + start;
+}
+
+void resetArena(Arena *arena)
+{
+  arena->used = 0;
+  arena->allocations = 0;
+}
+
+#ifdef ARENA_DEBUG
+
+/* Linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc so calls made
+  from this program's objects land here first. Allocations made inside
+  SDL or libc are not seen. */
+
+static size_t heap_allocations = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+  __atomic_add_fetch(&heap_allocations, 1, __ATOMIC_RELAXED);
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+  __atomic_add_fetch(&heap_allocations, 1, __ATOMIC_RELAXED);
+  return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+  __atomic_add_fetch(&heap_allocations, 1, __ATOMIC_RELAXED);
+  return __real_realloc(ptr, size);
+}
+
+size_t heapAllocations(void)
+{
+  return __atomic_load_n(&heap_allocations, __ATOMIC_RELAXED);
+}
+
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdalign.h>
+
+#define ARENA_ALIGN alignof(max_align_t)
+
+/* BUMP ALLOCATOR
+  One block is allocated up front and handed out in aligned slices.
+  Nothing is freed individually; resetArena() reclaims everything at once
+  and destroyArena() gives the block back. Allocations past the end fail
+  with NULL instead of growing, so sizes have to be planned for. */
+
+typedef struct Arena {
+  uint8_t *base;
+  size_t size, used;
+  size_t allocations; // since the last reset
+} Arena;
+
+Arena *createArena(size_t size);
+void destroyArena(Arena *arena);
+
+void *arenaAlloc(size_t size, Arena *arena);
+void resetArena(Arena *arena);
+
+#ifdef ARENA_DEBUG
+// every malloc/calloc/realloc made by this program's own code, see Makefile
+size_t heapAllocations(void);
+#endif
@@ -0,0 +1,265 @@
+#include <SDL2/SDL.h>
+#include "SDL_image.h"
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "renderer.h"
+#include "viewport.h"
+#include "scrollmap.h"
+
+// PIXELS PER UNIT
+#define BASE_PPU 100.0f
+
+#define NODE_SIZE 10
+#define MAX_IMAGE_SIDE 8192
+
+/* Headless batch exporter
+
+  Renders one PNG per line of a views file:
+
+    lat, lon, scale, width, height
+
+  lat/lon is the center of the image, scale is the same zoom the
+  interactive viewport uses (1.0 == BASE_PPU pixels per unit).
+
+  Views are handed out to a pool of worker threads. Every worker owns its
+  surface and software renderer, so nothing but the loaded map is shared
+  and the map is only ever read. */
+
+typedef struct ExportView {
+  SDL_FPoint center;
+  float scale;
+  int width, height;
+} ExportView;
+
+typedef struct ExportJob {
+  ScrollMap *sm;
+  ExportView *views;
+  size_t number_of_views;
+  const char *out_dir;
+  SDL_atomic_t next;
+  SDL_atomic_t failed;
+} ExportJob;
+
+static size_t loadViewsFromFile(FILE* views_file, ExportView **views)
+{
+  size_t number_of_views = 0, capacity = 0, line_number = 0;
+  char* line = NULL;
+  size_t len = 0;
+  *views = NULL;
+
+  while( getline(&line, &len, views_file) != -1)
+  {
+    line_number++;
+    float fields[5];
+    int n = 0;
+    for(char *token = strtok(line, " ,\n"); token && n < 5; token = strtok(NULL, " ,\n"))
+      fields[n++] = atof(token);
+
+    if(n < 5 || fields[2] <= 0.0f
+      || fields[3] < 1 || fields[3] > MAX_IMAGE_SIDE
+      || fields[4] < 1 || fields[4] > MAX_IMAGE_SIDE)
+    {
+      if(n) fprintf(stderr, "Skipping malformed view on line %zu\n", line_number);
+      continue;
+    }
+
+    if(number_of_views == capacity)
+    {
+      capacity = capacity ? capacity * 2 : 64;
+      ExportView *grown = realloc(*views, capacity * sizeof(ExportView));
+      if(!grown) break;
+      *views = grown;
+    }
+
+    ExportView *v = &(*views)[number_of_views++];
+    v->center.x = fields[0];
+    v->center.y = fields[1];
+    v->scale  = fields[2];
+    v->width  = fields[3];
+    v->height = fields[4];
+  }
+
+  free(line);
+  return number_of_views;
+}
+
+// Same math as the interactive Viewport, without allocating one
+static void frameViewport(ExportView *v, ScrollMap *sm, Viewport *vw)
+{
+  vw->width = v->width;
+  vw->height = v->height;
+  vw->scale = v->scale;
+  vw->base_ppu = BASE_PPU;
+  vw->pixels_per_unit = vw->base_ppu * vw->scale;
+
+  MapPoint focus;
+  latLonToPt(v->center.x, v->center.y, &focus, sm->map->aspect_ratio);
+  vw->focus.x = focus.x;
+  vw->focus.y = focus.y;
+
+  vw->view.x = vw->focus.x - ( vw->width  / 2.0f ) / vw->pixels_per_unit;
+  vw->view.y = vw->focus.y - ( vw->height / 2.0f ) / vw->pixels_per_unit;
+}
+
+static void drawSnapshot(ScrollMap *sm, Viewport *vw, Renderer *ren)
+{
+  setRenderDrawColor(0x20, 0x20, 0x20, ren);
+  clear(ren);
+
+  SDL_Rect box;
+  box.w = box.h = NODE_SIZE;
+  SDL_FPoint node, prev;
+  for(int i = 0; i < sm->map->number_of_nodes; i++)
+  {
+    node = nodeAt(i, sm);
+    drawNode(&box, &node, &(vw->view), vw->pixels_per_unit, ren);
+    if(i > 0) drawLine(&prev, &node, &(vw->view), vw->pixels_per_unit, ren);
+    prev = node;
+  }
+}
+
+static int exportWorker(void *data)
+{
+  ExportJob *job = data;
+  SDL_Surface *surface = NULL;
+  Renderer *ren = NULL;
+  char path[4096];
+  int i;
+
+  while((i = SDL_AtomicAdd(&job->next, 1)) < (int)job->number_of_views)
+  {
+    ExportView *v = &job->views[i];
+
+    // views of the same size reuse the surface and renderer
+    if(!surface || surface->w != v->width || surface->h != v->height)
+    {
+      if(ren) destroyRenderer(ren);
+      if(surface) SDL_FreeSurface(surface);
+      ren = NULL;
+
+      surface = SDL_CreateRGBSurfaceWithFormat(0, v->width, v->height, 32, SDL_PIXELFORMAT_RGBA32);
+      if(!surface)
+      {
+        fprintf(stderr, "SDL_CreateRGBSurfaceWithFormat FAILED: %s\n", SDL_GetError());
+        SDL_AtomicAdd(&job->failed, 1);
+        continue;
+      }
+
+      ren = createSurfaceRenderer(surface);
+      if(!ren)
+      {
+        SDL_FreeSurface(surface);
+        surface = NULL;
+        SDL_AtomicAdd(&job->failed, 1);
+        continue;
+      }
+    }
+
+    Viewport vw;
+    frameViewport(v, job->sm, &vw);
+    drawSnapshot(job->sm, &vw, ren);
+
+    snprintf(path, sizeof(path), "%s/view_%05d.png", job->out_dir, i);
+    if(IMG_SavePNG(surface, path) != 0)
+    {
+      fprintf(stderr, "IMG_SavePNG(%s) FAILED: %s\n", path, SDL_GetError());
+      SDL_AtomicAdd(&job->failed, 1);
+    }
+  }
+
+  if(ren) destroyRenderer(ren);
+  if(surface) SDL_FreeSurface(surface);
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  if(argc < 3)
+  {
+    fprintf(stderr, "usage: %s <views file> <output dir> [workers] [nodes file]\n", argv[0]);
+    return 1;
+  }
+
+  const char *nodes_filename = argc > 4 ? argv[4] : "nodes.txt";
+
+  if(SDL_Init(0) != 0)
+  {
+    fprintf(stderr, "SDL_Init(0) FAILED: %s\n", SDL_GetError());
+    return 1;
+  }
+
+  int workers = argc > 3 ? atoi(argv[3]) : SDL_GetCPUCount();
+  if(workers < 1) workers = 1;
+
+  FILE* views_file = fopen(argv[1], "r");
+  if(!views_file)
+  {
+    fprintf(stderr, "Failed to open file: %s\n", argv[1]);
+    SDL_Quit();
+    return 1;
+  }
+
+  ExportView *views;
+  size_t number_of_views = loadViewsFromFile(views_file, &views);
+  fclose(views_file);
+
+  if(!number_of_views)
+  {
+    fprintf(stderr, "No views to export in %s\n", argv[1]);
+    free(views);
+    SDL_Quit();
+    return 1;
+  }
+
+  // the map's own viewport is unused here, every view frames itself
+  ScrollMap *sm = createScrollMap(views[0].width, views[0].height, BASE_PPU, nodes_filename);
+  if(!sm)
+  {
+    free(views);
+    SDL_Quit();
+    return 1;
+  }
+
+  ExportJob job;
+  job.sm = sm;
+  job.views = views;
+  job.number_of_views = number_of_views;
+  job.out_dir = argv[2];
+  SDL_AtomicSet(&job.next, 0);
+  SDL_AtomicSet(&job.failed, 0);
+
+  if((size_t)workers > number_of_views) workers = number_of_views;
+  SDL_Thread **threads = malloc(workers * sizeof(SDL_Thread *));
+
+  Uint64 start = SDL_GetPerformanceCounter();
+
+  int started = 0;
+  for(int i = 0; i < workers; i++)
+  {
+    threads[started] = SDL_CreateThread(exportWorker, "export", &job);
+    if(!threads[started]) fprintf(stderr, "SDL_CreateThread FAILED: %s\n", SDL_GetError());
+    else started++;
+  }
+
+  // nothing could be spawned, so do the work on this thread instead
+  if(!started) exportWorker(&job);
+
+  for(int i = 0; i < started; i++)
+    SDL_WaitThread(threads[i], NULL);
+
+  double seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+  size_t exported = number_of_views - SDL_AtomicGet(&job.failed);
+
+  printf("Exported %zu/%zu images in %.3fs with %d workers: %.1f images/sec\n",
+    exported, number_of_views, seconds, started ? started : 1, exported / seconds);
+
+  free(threads);
+  free(views);
+  destroyScrollMap(sm);
+  SDL_Quit();
+
+  return exported == number_of_views ? 0 : 1;
+}
@@ -7,6 +7,9 @@
 #include "renderer.h"
 #include "viewport.h"
 #include "scrollmap.h"
+#include "nodewatch.h"
+#include "viewanim.h"
+#include "arena.h"
 
 #define WIDTH 1000
 #define HEIGHT 800
@@ -17,6 +20,11 @@
 // PIXELS PER UNIT
 #define BASE_PPU 100.0f
 
+#define NODES_FILE "nodes.txt"
+
+// scratch memory for a single frame, reset at the top of the loop
+#define FRAME_ARENA_SIZE (256 * 1024)
+
 int main(int argc, char **argv)
 {
   if(SDL_Init(SDL_INIT_VIDEO) != 0)
@@ -26,15 +34,32 @@ int main(int argc, char **argv)
   }
 
   Renderer *renderer = createRenderer(WIDTH, HEIGHT);
-  if(!renderer) SDL_Quit();
+  if(!renderer)
+  {
+    SDL_Quit();
+    return 1;
+  }
 
-  ScrollMap *sm = createScrollMap(WIDTH, HEIGHT, BASE_PPU, "nodes.txt");
+  ScrollMap *sm = createScrollMap(WIDTH, HEIGHT, BASE_PPU, NODES_FILE);
   if(!sm)
   {
     destroyRenderer(renderer);
     SDL_Quit();
+    return 1;
   }
 
+  Arena *frame = createArena(FRAME_ARENA_SIZE);
+  if(!frame)
+  {
+    destroyScrollMap(sm);
+    destroyRenderer(renderer);
+    SDL_Quit();
+    return 1;
+  }
+
+  // keep running without live reload if the watch can't be set up
+  NodeWatch *nw = createNodeWatch(NODES_FILE);
+
   SDL_Rect box;
 
   float box_x = (sm->vw->focus.x + sm->vw->view.x) / 2;
@@ -44,14 +69,22 @@ int main(int argc, char **argv)
   float box_h = (sm->vw->focus.y - sm->vw->view.y);
 
   bool quit  = false;
-  SDL_Point mouse, motion;
-  mouse.x = mouse.y = motion.x = motion.y = 0;
-  float scroll_y  = 0;
+  SDL_Point mouse;
+
+  ViewAnim anim;
+  initViewAnim(&anim, MIN_SCALE, MAX_SCALE, sm->vw);
+
+  Uint64 frame_time = SDL_GetPerformanceCounter();
 
 ////////////////////////////// LOOP /////////////////////////////////
 
   while(true)
   {
+    resetArena(frame);
+#ifdef ARENA_DEBUG
+    size_t heap_allocations = heapAllocations();
+#endif
+
     SDL_Event event;
 
     while(SDL_PollEvent(&event))
@@ -72,18 +105,24 @@ int main(int argc, char **argv)
           }
           break;
 
+        // only the left button drags the map
+        case SDL_MOUSEBUTTONDOWN:
+          if(event.button.button == SDL_BUTTON_LEFT) animPress(&anim);
+          break;
+
+        case SDL_MOUSEBUTTONUP:
+          if(event.button.button == SDL_BUTTON_LEFT) animRelease(&anim, event.button.timestamp);
+          break;
+
         case SDL_MOUSEMOTION:
-          if(event.motion.state)
-          {
-            motion.x = event.motion.xrel;
-            motion.y = event.motion.yrel;
-          }
+          if(event.motion.state & SDL_BUTTON_LMASK)
+            animMotion(&anim, event.motion.xrel, event.motion.yrel, event.motion.timestamp);
           break;
 
         case SDL_MOUSEWHEEL:
-          scroll_y = event.wheel.preciseY;
           mouse.x  = event.wheel.mouseX;
           mouse.y  = event.wheel.mouseY;
+          animScroll(&anim, event.wheel.preciseY, mouse);
           break;
 
         case SDL_QUIT:
@@ -95,20 +134,13 @@ int main(int argc, char **argv)
       }
     }
 
-    if(motion.x || motion.y)
-    {
-      printf("Dragging: motion.x: %d\tmotion.y: %d\n", motion.x, motion.y);
-      // TODO: not as fluid as it could be with this strategy ...
-      handleMotion(motion, sm->vw);
-      motion.x = motion.y = 0;
-    }
+    if(nw && nodesFileChanged(nw)) reloadMapData(sm->map, NODES_FILE, frame);
 
-    if(scroll_y)
-    {
-      printf("Scrolling (%d)\tmouse.x: %d\tmouse.y: %d\n", (int)scroll_y, mouse.x, mouse.y);
-      handleScroll(scroll_y, mouse, MIN_SCALE, MAX_SCALE, sm->vw);
-      scroll_y = 0.0f;
-    }
+    // the view advances by real elapsed time every frame, events or not
+    Uint64 now = SDL_GetPerformanceCounter();
+    float dt = (float)(now - frame_time) / SDL_GetPerformanceFrequency();
+    frame_time = now;
+    stepViewAnim(&anim, dt, sm->vw);
 
     // Clear the screen
     setRenderDrawColor(0x20, 0x20, 0x20, renderer);
@@ -129,16 +161,29 @@ int main(int argc, char **argv)
 
     // Draw fixed size node markers on the map and connect with lines
     box.w = box.h = 10;
-    for(int i = 0; i < sm->number_of_nodes; i++)
+    SDL_FPoint node, prev;
+    for(int i = 0; i < sm->map->number_of_nodes; i++)
     {
-      drawNode(&box, &(sm->nodes[i]), &(sm->vw->view), sm->vw->pixels_per_unit, renderer);
-      if(i > 0 && i < sm->number_of_nodes) drawLine(&(sm->nodes[i-1]), &(sm->nodes[i]), &(sm->vw->view), sm->vw->pixels_per_unit, renderer);
+      node = nodeAt(i, sm);
+      drawNode(&box, &node, &(sm->vw->view), sm->vw->pixels_per_unit, renderer);
+      if(i > 0 && i < sm->map->number_of_nodes) drawLine(&prev, &node, &(sm->vw->view), sm->vw->pixels_per_unit, renderer);
+      prev = node;
     }
 
     display(renderer);
+
+#ifdef ARENA_DEBUG
+    // the steady state frame should never reach the heap
+    if(heapAllocations() != heap_allocations)
+      fprintf(stderr, "Frame made %zu heap allocations (%zu from the frame arena)\n",
+        heapAllocations() - heap_allocations, frame->allocations);
+#endif
+
     if(quit) break;
   }
 
+  destroyArena(frame);
+  if(nw) destroyNodeWatch(nw);
   destroyScrollMap(sm);
   destroyRenderer(renderer);
   SDL_Quit();
@@ -0,0 +1,230 @@
+#include "mapdata.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// radius of earth in miles
+#define RADIUS_EARTH 3958.8
+
+#define MAX_LINE_LENGTH 256
+
+float rad(float deg) { return (deg * M_PI) / 180.0f; }
+
+/* SIMPLE EQUIRECTANGULAR PROJECTION
+  x = radius_earth * longitude * cos( average latitude )
+  y = radius_earth * latitude
+  ( latitude and longitude must be converted to radians ) */
+
+void latLonToPt(float lat, float lon, MapPoint *p, float aspect_ratio)
+{
+  p->x = RADIUS_EARTH * rad(lon) * aspect_ratio;
+  p->y = RADIUS_EARTH * rad(lat) * -1.0f;
+}
+
+// great circle distance (haversine), for answers that shouldn't depend on the projection
+float distanceMiles(float lat0, float lon0, float lat1, float lon1)
+{
+  float dlat = rad(lat1 - lat0);
+  float dlon = rad(lon1 - lon0);
+  float h = sin(dlat / 2) * sin(dlat / 2) + cos(rad(lat0)) * cos(rad(lat1)) * sin(dlon / 2) * sin(dlon / 2);
+  return 2.0f * RADIUS_EARTH * asin(sqrt(h));
+}
+
+size_t mapDataSize(size_t capacity)
+{
+  // each of the three allocations may be padded out to the arena's alignment
+  return sizeof(MapData) + 2 * capacity * sizeof(MapPoint) + 3 * ARENA_ALIGN;
+}
+
+MapData *createMapData(size_t capacity, Arena *arena)
+{
+  MapData *map = arenaAlloc(sizeof(MapData), arena);
+  if(!map) return NULL;
+
+  map->nodes = arenaAlloc(capacity * sizeof(MapPoint), arena);
+  map->lat_lon = arenaAlloc(capacity * sizeof(MapPoint), arena);
+  if(!map->nodes || !map->lat_lon) return NULL;
+
+  map->number_of_nodes = 0;
+  map->capacity = capacity;
+  map->aspect_ratio = 1.0f;
+  return map;
+}
+
+// lines beyond capacity are ignored, NULL if the file can't be read or has no nodes
+MapData *loadMapData(const char nodes_filename[], size_t capacity, Arena *arena)
+{
+  FILE* nodes_file = fopen(nodes_filename, "r");
+  if (!nodes_file)
+  {
+    fprintf(stderr, "Failed to open file: %s\n", nodes_filename);
+    return NULL;
+  }
+
+  MapData *map = createMapData(capacity, arena);
+  if(!map)
+  {
+    fclose(nodes_file);
+    return NULL;
+  }
+
+  loadNodesFromFile(nodes_file, map);
+  fclose(nodes_file);
+
+  if(!map->number_of_nodes)
+  {
+    fprintf(stderr, "No nodes found in file: %s\n", nodes_filename);
+    return NULL;
+  }
+
+  return map;
+}
+
+// upper bound on the nodes in a file, for sizing a map before loading it
+size_t countLines(FILE* nodes_file)
+{
+  size_t lines = 0;
+  int c, last = '\n';
+
+  while((c = fgetc(nodes_file)) != EOF)
+  {
+    if(c == '\n') lines++;
+    last = c;
+  }
+  if(last != '\n') lines++;
+
+  rewind(nodes_file);
+  return lines;
+}
+
+// TODO: error check ... and eventually make more flexible
+size_t readLatLonPairs(FILE* nodes_file, MapPoint lat_lon_pairs[], size_t max_pairs)
+{
+  size_t number_of_pairs = 0;
+  char line[MAX_LINE_LENGTH];
+
+  while(number_of_pairs < max_pairs && fgets(line, sizeof(line), nodes_file))
+  {
+    // the rest of an over-long line is dropped rather than read as another node
+    if(!strchr(line, '\n'))
+    {
+      int c;
+      while((c = fgetc(nodes_file)) != '\n' && c != EOF) {}
+    }
+
+    char * token = strtok(line," ,\n");
+    if(!token) continue;
+    float lat = atof(token);
+    token = strtok(NULL, " ,\n");
+    if(!token) continue;
+    float lon = atof(token);
+    lat_lon_pairs[number_of_pairs].x = lat;
+    lat_lon_pairs[number_of_pairs].y = lon;
+    number_of_pairs++;
+  }
+
+  return number_of_pairs;
+}
+
+void loadNodesFromFile(FILE* nodes_file, MapData *map)
+{
+  map->number_of_nodes = readLatLonPairs(nodes_file, map->lat_lon, map->capacity);
+  if(!map->number_of_nodes) return;
+
+  float sum_of_lats = 0.0f;
+  for(int i = 0; i < map->number_of_nodes; i++)
+    sum_of_lats += map->lat_lon[i].x;
+
+  float avg_lat = sum_of_lats / map->number_of_nodes;
+  map->aspect_ratio = cos( rad(avg_lat) );
+
+  // convert lat lon pairs to 2D points
+  for(int i = 0; i < map->number_of_nodes; i++)
+    latLonToPt(map->lat_lon[i].x, map->lat_lon[i].y, &map->nodes[i], map->aspect_ratio);
+}
+
+static bool samePair(MapPoint *a, MapPoint *b)
+{
+  return a->x == b->x && a->y == b->y;
+}
+
+/* Diff the new pairs against the loaded ones and patch only what changed.
+  Nodes are an ordered path, so the unchanged prefix and suffix are skipped.
+  Where the old and new spans between them overlap, nodes are compared in
+  place and only the ones that differ are reprojected, so editing the first
+  and last node costs two projections, not the whole path. The aspect ratio
+  from the initial load is kept so untouched nodes never move. Returns the
+  number of nodes that were inserted, deleted or moved. */
+
+size_t applyNodeChanges(MapPoint lat_lon_pairs[], size_t number_of_pairs, MapData *map)
+{
+  size_t old_n = map->number_of_nodes;
+  size_t new_n = number_of_pairs;
+
+  size_t prefix = 0;
+  while(prefix < old_n && prefix < new_n && samePair(&map->lat_lon[prefix], &lat_lon_pairs[prefix]))
+    prefix++;
+
+  size_t suffix = 0;
+  while(suffix < old_n - prefix && suffix < new_n - prefix
+    && samePair(&map->lat_lon[old_n - 1 - suffix], &lat_lon_pairs[new_n - 1 - suffix]))
+    suffix++;
+
+  size_t old_span = old_n - prefix - suffix;
+  size_t new_span = new_n - prefix - suffix;
+  if(!old_span && !new_span) return 0;
+
+  // slide the untouched tail over when nodes were inserted or deleted
+  if(old_span != new_span && suffix)
+  {
+    memmove(&map->lat_lon[prefix + new_span], &map->lat_lon[prefix + old_span], suffix * sizeof(MapPoint));
+    memmove(&map->nodes[prefix + new_span], &map->nodes[prefix + old_span], suffix * sizeof(MapPoint));
+  }
+
+  // the tail slides past the overlap, so its old nodes are still in place here
+  size_t overlap = old_span < new_span ? old_span : new_span;
+  size_t moved = 0;
+  for(size_t i = prefix; i < prefix + new_span; i++)
+  {
+    if(i < prefix + overlap)
+    {
+      if(samePair(&map->lat_lon[i], &lat_lon_pairs[i])) continue;
+      moved++;
+    }
+    map->lat_lon[i] = lat_lon_pairs[i];
+    latLonToPt(map->lat_lon[i].x, map->lat_lon[i].y, &map->nodes[i], map->aspect_ratio);
+  }
+
+  map->number_of_nodes = new_n;
+
+  size_t inserted = new_span - overlap;
+  size_t deleted = old_span - overlap;
+  printf("Reloaded nodes: %zu moved\t%zu inserted\t%zu deleted\n", moved, inserted, deleted);
+  return moved + inserted + deleted;
+}
+
+// any view of the map is left alone so the user keeps their place
+bool reloadMapData(MapData *map, const char nodes_filename[], Arena *scratch)
+{
+  FILE* nodes_file = fopen(nodes_filename, "r");
+  if (!nodes_file)
+  {
+    fprintf(stderr, "Failed to open file: %s\n", nodes_filename);
+    return false;
+  }
+
+  MapPoint *lat_lon_pairs = arenaAlloc(map->capacity * sizeof(MapPoint), scratch);
+  if(!lat_lon_pairs)
+  {
+    fclose(nodes_file);
+    return false;
+  }
+
+  size_t number_of_pairs = readLatLonPairs(nodes_file, lat_lon_pairs, map->capacity);
+  fclose(nodes_file);
+
+  // an editor may truncate the file before writing it back out
+  if(!number_of_pairs) return false;
+
+  return applyNodeChanges(lat_lon_pairs, number_of_pairs, map) > 0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "arena.h"
+
+/* Map loading, projection and diffing with no renderer attached, shared by
+  the SDL viewer and the headless query server. */
+
+typedef struct MapPoint {
+  float x, y;
+} MapPoint;
+
+typedef struct MapData {
+  MapPoint *nodes;   // projected, in miles
+  MapPoint *lat_lon; // as read from file (x = lat, y = lon), kept for diffing on reload
+  size_t number_of_nodes, capacity;
+  float aspect_ratio;
+} MapData;
+
+// bytes of arena a map of this many nodes needs
+size_t mapDataSize(size_t capacity);
+
+MapData *createMapData(size_t capacity, Arena *arena);
+MapData *loadMapData(const char nodes_filename[], size_t capacity, Arena *arena);
+
+float rad(float deg);
+void latLonToPt(float lat, float lon, MapPoint *p, float aspect_ratio);
+float distanceMiles(float lat0, float lon0, float lat1, float lon1);
+
+size_t countLines(FILE* nodes_file);
+size_t readLatLonPairs(FILE* nodes_file, MapPoint lat_lon_pairs[], size_t max_pairs);
+void loadNodesFromFile(FILE* nodes_file, MapData *map);
+size_t applyNodeChanges(MapPoint lat_lon_pairs[], size_t number_of_pairs, MapData *map);
+bool reloadMapData(MapData *map, const char nodes_filename[], Arena *scratch);
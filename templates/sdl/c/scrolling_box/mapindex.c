@@ -0,0 +1,218 @@
+#include "mapindex.h"
+#include <math.h>
+
+// average number of nodes the grid aims to put in a cell
+#define NODES_PER_CELL 4
+
+static size_t cellsPerSide(size_t number_of_nodes)
+{
+  size_t side = ceil(sqrt((double)number_of_nodes / NODES_PER_CELL));
+  return side ? side : 1;
+}
+
+size_t mapIndexSize(size_t number_of_nodes)
+{
+  size_t side = cellsPerSide(number_of_nodes);
+  return sizeof(MapIndex) + number_of_nodes * sizeof(MapRecord)
+    + (side * side + 1) * sizeof(uint32_t) * 2 + 4 * ARENA_ALIGN;
+}
+
+// clamped before the int conversion, which is undefined out of range
+static int cellX(float x, MapIndex *index)
+{
+  float cx = (x - index->min_x) / index->cell_size;
+  if(!(cx >= 0.0f)) return 0;
+  if(cx >= index->cells_x) return index->cells_x - 1;
+  return cx;
+}
+
+static int cellY(float y, MapIndex *index)
+{
+  float cy = (y - index->min_y) / index->cell_size;
+  if(!(cy >= 0.0f)) return 0;
+  if(cy >= index->cells_y) return index->cells_y - 1;
+  return cy;
+}
+
+// counting sort of the nodes into row-major cell order
+MapIndex *createMapIndex(MapData *map, Arena *arena)
+{
+  size_t n = map->number_of_nodes;
+  if(!n || n > UINT32_MAX) return NULL;
+
+  MapIndex *index = arenaAlloc(sizeof(MapIndex), arena);
+  if(!index) return NULL;
+
+  float min_x = map->nodes[0].x, max_x = min_x;
+  float min_y = map->nodes[0].y, max_y = min_y;
+  index->min_lat = index->max_lat = map->lat_lon[0].x;
+  index->min_lon = index->max_lon = map->lat_lon[0].y;
+
+  for(size_t i = 1; i < n; i++)
+  {
+    MapPoint *p = &map->nodes[i], *ll = &map->lat_lon[i];
+    if(p->x < min_x) min_x = p->x;
+    if(p->x > max_x) max_x = p->x;
+    if(p->y < min_y) min_y = p->y;
+    if(p->y > max_y) max_y = p->y;
+    if(ll->x < index->min_lat) index->min_lat = ll->x;
+    if(ll->x > index->max_lat) index->max_lat = ll->x;
+    if(ll->y < index->min_lon) index->min_lon = ll->y;
+    if(ll->y > index->max_lon) index->max_lon = ll->y;
+  }
+
+  size_t side = cellsPerSide(n);
+  float span = fmaxf(max_x - min_x, max_y - min_y);
+
+  index->min_x = min_x;
+  index->min_y = min_y;
+  index->cell_size = span > 0.0f ? span / side : 1.0f;
+  index->cells_x = fminf(side, floorf((max_x - min_x) / index->cell_size) + 1);
+  index->cells_y = fminf(side, floorf((max_y - min_y) / index->cell_size) + 1);
+  index->aspect_ratio = map->aspect_ratio;
+  index->number_of_records = n;
+
+  size_t cells = (size_t)index->cells_x * index->cells_y;
+  index->records = arenaAlloc(n * sizeof(MapRecord), arena);
+  index->cell_start = arenaAlloc((cells + 1) * sizeof(uint32_t), arena);
+  uint32_t *fill = arenaAlloc((cells + 1) * sizeof(uint32_t), arena);
+  if(!index->records || !index->cell_start || !fill) return NULL;
+
+  for(size_t c = 0; c <= cells; c++) index->cell_start[c] = 0;
+  for(size_t i = 0; i < n; i++)
+    index->cell_start[cellY(map->nodes[i].y, index) * index->cells_x + cellX(map->nodes[i].x, index) + 1]++;
+  for(size_t c = 0; c < cells; c++)
+  {
+    index->cell_start[c + 1] += index->cell_start[c];
+    fill[c] = index->cell_start[c];
+  }
+
+  for(size_t i = 0; i < n; i++)
+  {
+    size_t c = cellY(map->nodes[i].y, index) * index->cells_x + cellX(map->nodes[i].x, index);
+    MapRecord *r = &index->records[fill[c]++];
+    r->id = i;
+    r->lat = map->lat_lon[i].x;
+    r->lon = map->lat_lon[i].y;
+    r->x = map->nodes[i].x;
+    r->y = map->nodes[i].y;
+  }
+
+  return index;
+}
+
+/* Every node inside the box, as runs of consecutive records. A row of cells
+  is contiguous in the record array, so hits along a row merge into long
+  runs. Stops once max_records have been found. Returns the number of runs. */
+
+size_t queryBox(float lat0, float lon0, float lat1, float lon1,
+  MapRun runs[], size_t max_records, size_t *number_of_records, MapIndex *index)
+{
+  MapPoint a, b;
+  latLonToPt(lat0, lon0, &a, index->aspect_ratio);
+  latLonToPt(lat1, lon1, &b, index->aspect_ratio);
+
+  float lo_x = fminf(a.x, b.x), hi_x = fmaxf(a.x, b.x);
+  float lo_y = fminf(a.y, b.y), hi_y = fmaxf(a.y, b.y);
+
+  size_t number_of_runs = 0, found = 0;
+  *number_of_records = 0;
+
+  float max_x = index->min_x + index->cells_x * index->cell_size;
+  float max_y = index->min_y + index->cells_y * index->cell_size;
+  if(hi_x < index->min_x || lo_x > max_x || hi_y < index->min_y || lo_y > max_y) return 0;
+
+  int x0 = cellX(lo_x, index), x1 = cellX(hi_x, index);
+  int y0 = cellY(lo_y, index), y1 = cellY(hi_y, index);
+
+  for(int cy = y0; cy <= y1 && found < max_records; cy++)
+  {
+    uint32_t start = index->cell_start[cy * index->cells_x + x0];
+    uint32_t end = index->cell_start[cy * index->cells_x + x1 + 1];
+    MapRun *run = NULL;
+
+    for(uint32_t i = start; i < end && found < max_records; i++)
+    {
+      MapRecord *r = &index->records[i];
+      if(r->x < lo_x || r->x > hi_x || r->y < lo_y || r->y > hi_y)
+      {
+        run = NULL;
+        continue;
+      }
+
+      if(!run)
+      {
+        run = &runs[number_of_runs++];
+        run->first = i;
+        run->count = 0;
+      }
+      run->count++;
+      found++;
+    }
+  }
+
+  *number_of_records = found;
+  return number_of_runs;
+}
+
+/* The k nodes closest to a point, nearest first, by projected distance, as
+  positions in index->records.
+  Rings of cells are searched outward from the point's cell until nothing
+  further out can beat the k-th best. The miles handed back are great circle
+  miles, the same as distanceMiles, so they agree with MAP_OP_DISTANCE.
+  Returns how many were found. */
+
+size_t queryNearest(float lat, float lon, size_t k,
+  uint32_t nearest[], float miles[], MapIndex *index)
+{
+  if(!k) return 0;
+
+  MapPoint p;
+  latLonToPt(lat, lon, &p, index->aspect_ratio);
+  int cx = cellX(p.x, index), cy = cellY(p.y, index);
+
+  int max_ring = index->cells_x > index->cells_y ? index->cells_x : index->cells_y;
+  size_t found = 0;
+
+  for(int ring = 0; ring <= max_ring; ring++)
+  {
+    for(int y = cy - ring; y <= cy + ring; y++)
+    {
+      if(y < 0 || y >= index->cells_y) continue;
+
+      // only the outline of the ring, the inside was searched already
+      int step = (y == cy - ring || y == cy + ring) ? 1 : 2 * ring;
+      for(int x = cx - ring; x <= cx + ring; x += step)
+      {
+        if(x < 0 || x >= index->cells_x) continue;
+
+        uint32_t start = index->cell_start[y * index->cells_x + x];
+        uint32_t end = index->cell_start[y * index->cells_x + x + 1];
+        for(uint32_t i = start; i < end; i++)
+        {
+          float d = hypotf(index->records[i].x - p.x, index->records[i].y - p.y);
+          if(found == k && d >= miles[k - 1]) continue;
+
+          // insertion into the sorted best-k list
+          size_t j = found < k ? found++ : k - 1;
+          while(j > 0 && miles[j - 1] > d)
+          {
+            miles[j] = miles[j - 1];
+            nearest[j] = nearest[j - 1];
+            j--;
+          }
+          miles[j] = d;
+          nearest[j] = i;
+        }
+      }
+    }
+
+    // cells outside this ring are at least ring * cell_size away
+    if(found == k && miles[k - 1] <= ring * index->cell_size) break;
+  }
+
+  for(size_t i = 0; i < found; i++)
+    miles[i] = distanceMiles(lat, lon, index->records[nearest[i]].lat, index->records[nearest[i]].lon);
+
+  return found;
+}
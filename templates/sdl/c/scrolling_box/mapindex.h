@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "mapdata.h"
+
+/* Read-only grid index over a loaded map for viewport and nearest-node
+  queries. Nodes are copied once, at build time, into records sorted by
+  grid cell; every query after that hands back positions inside that one
+  array, so callers can send results straight out of it. */
+
+// also the wire format for a node, see mapproto.h
+typedef struct MapRecord {
+  uint32_t id;   // position in load order, 0 based; blank and malformed lines are skipped
+  float lat, lon;
+  float x, y;    // projected, in miles
+} MapRecord;
+
+// records[first] .. records[first + count - 1]
+typedef struct MapRun {
+  uint32_t first, count;
+} MapRun;
+
+typedef struct MapIndex {
+  MapRecord *records;
+  uint32_t *cell_start; // cells_x * cells_y + 1 offsets into records
+  size_t number_of_records;
+  int cells_x, cells_y;
+  float min_x, min_y, cell_size;
+  float aspect_ratio;
+  float min_lat, min_lon, max_lat, max_lon;
+} MapIndex;
+
+size_t mapIndexSize(size_t number_of_nodes);
+MapIndex *createMapIndex(MapData *map, Arena *arena);
+
+size_t queryBox(float lat0, float lon0, float lat1, float lon1,
+  MapRun runs[], size_t max_records, size_t *number_of_records, MapIndex *index);
+
+size_t queryNearest(float lat, float lon, size_t k,
+  uint32_t nearest[], float miles[], MapIndex *index);
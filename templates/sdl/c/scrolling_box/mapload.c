@@ -0,0 +1,270 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "mapproto.h"
+
+/* Load generator for mapserver
+
+  Opens one connection per client thread and sends back to back queries,
+  alternating between a box around a random point and its NEAREST_K
+  nearest nodes. Every round trip is timed. Queries/sec and latency
+  percentiles over all clients are printed at the end. */
+
+#define DEFAULT_CLIENTS 8
+#define DEFAULT_QUERIES 10000
+
+// box side as a fraction of the map's extent
+#define BOX_FRACTION 0.05f
+#define NEAREST_K 8
+
+typedef struct LoadClient {
+  const char *socket_path;
+  MapResponse info;
+  size_t number_of_queries;
+  double *latencies; // microseconds
+  unsigned int seed;
+  size_t failed;
+} LoadClient;
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int connectTo(const char socket_path[])
+{
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if(fd < 0) return -1;
+
+  if(connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+  {
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+static bool readAll(int fd, void *buf, size_t len)
+{
+  while(len)
+  {
+    ssize_t got = read(fd, buf, len);
+    if(got < 0 && errno == EINTR) continue;
+    if(got <= 0) return false;
+    buf = (char *)buf + got;
+    len -= got;
+  }
+  return true;
+}
+
+static bool writeAll(int fd, const void *buf, size_t len)
+{
+  while(len)
+  {
+    ssize_t sent = write(fd, buf, len);
+    if(sent < 0 && errno == EINTR) continue;
+    if(sent <= 0) return false;
+    buf = (const char *)buf + sent;
+    len -= sent;
+  }
+  return true;
+}
+
+// the body is read into a reusable buffer and discarded
+static bool query(int fd, MapRequest *req, MapResponse *res, void *body, size_t body_size)
+{
+  if(!writeAll(fd, req, sizeof(*req)) || !readAll(fd, res, sizeof(*res))) return false;
+
+  size_t len = res->count * sizeof(MapRecord);
+  if(req->op == MAP_OP_NEAREST) len += res->count * sizeof(float);
+  else if(req->op == MAP_OP_INFO) len = 0;
+  if(len > body_size) return false;
+
+  return readAll(fd, body, len);
+}
+
+static float randomBetween(float lo, float hi, unsigned int *seed)
+{
+  return lo + (hi - lo) * (rand_r(seed) / (float)RAND_MAX);
+}
+
+static void *runClient(void *data)
+{
+  LoadClient *client = data;
+  size_t body_size = MAP_MAX_RESULTS * (sizeof(MapRecord) + sizeof(float));
+  void *body = malloc(body_size);
+
+  int fd = connectTo(client->socket_path);
+  if(fd < 0 || !body)
+  {
+    perror("connect");
+    client->failed = client->number_of_queries;
+    free(body);
+    return NULL;
+  }
+
+  float min_lat = client->info.values[0], min_lon = client->info.values[1];
+  float max_lat = client->info.values[2], max_lon = client->info.values[3];
+  float half_lat = (max_lat - min_lat) * BOX_FRACTION / 2;
+  float half_lon = (max_lon - min_lon) * BOX_FRACTION / 2;
+
+  for(size_t q = 0; q < client->number_of_queries; q++)
+  {
+    float lat = randomBetween(min_lat, max_lat, &client->seed);
+    float lon = randomBetween(min_lon, max_lon, &client->seed);
+
+    MapRequest req;
+    memset(&req, 0, sizeof(req));
+    if(q % 2 == 0)
+    {
+      req.op = MAP_OP_BOX;
+      req.args[0] = lat - half_lat;
+      req.args[1] = lon - half_lon;
+      req.args[2] = lat + half_lat;
+      req.args[3] = lon + half_lon;
+    }
+    else
+    {
+      req.op = MAP_OP_NEAREST;
+      req.limit = NEAREST_K;
+      req.args[0] = lat;
+      req.args[1] = lon;
+    }
+
+    MapResponse res;
+    double start = now();
+    bool ok = query(fd, &req, &res, body, body_size);
+    client->latencies[q] = (now() - start) * 1e6;
+
+    if(!ok)
+    {
+      client->failed = client->number_of_queries - q;
+      break;
+    }
+  }
+
+  close(fd);
+  free(body);
+  return NULL;
+}
+
+static int compareLatency(const void *a, const void *b)
+{
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static double percentile(double sorted[], size_t n, double p)
+{
+  size_t i = p * (n - 1);
+  return sorted[i];
+}
+
+int main(int argc, char **argv)
+{
+  int clients = argc > 1 ? atoi(argv[1]) : DEFAULT_CLIENTS;
+  size_t queries = argc > 2 ? strtoul(argv[2], NULL, 10) : DEFAULT_QUERIES;
+  const char *socket_path = argc > 3 ? argv[3] : MAP_SOCKET_PATH;
+  if(clients < 1 || !queries)
+  {
+    fprintf(stderr, "usage: %s [clients] [queries per client] [socket path]\n", argv[0]);
+    return 1;
+  }
+
+  // learn the extent of the map so queries land on it
+  MapResponse info;
+  MapRequest req;
+  memset(&req, 0, sizeof(req));
+  req.op = MAP_OP_INFO;
+
+  int fd = connectTo(socket_path);
+  if(fd < 0 || !query(fd, &req, &info, NULL, 0))
+  {
+    fprintf(stderr, "Unable to reach mapserver on %s\n", socket_path);
+    if(fd >= 0) close(fd);
+    return 1;
+  }
+  close(fd);
+
+  printf("%u nodes in [%f, %f] - [%f, %f]\n", info.count,
+    info.values[0], info.values[1], info.values[2], info.values[3]);
+
+  size_t total = clients * queries;
+  double *latencies = malloc(total * sizeof(double));
+  LoadClient *load = malloc(clients * sizeof(LoadClient));
+  pthread_t *threads = malloc(clients * sizeof(pthread_t));
+  if(!latencies || !load || !threads)
+  {
+    fprintf(stderr, "Out of memory\n");
+    return 1;
+  }
+
+  double start = now();
+
+  int started = 0;
+  for(int i = 0; i < clients; i++)
+  {
+    LoadClient *client = &load[started];
+    client->socket_path = socket_path;
+    client->info = info;
+    client->number_of_queries = queries;
+    client->latencies = latencies + started * queries;
+    client->seed = i + 1;
+    client->failed = 0;
+
+    if(pthread_create(&threads[started], NULL, runClient, client) != 0)
+      fprintf(stderr, "pthread_create FAILED\n");
+    else started++;
+  }
+
+  for(int i = 0; i < started; i++)
+    pthread_join(threads[i], NULL);
+
+  double seconds = now() - start;
+
+  // keep only the round trips that completed
+  size_t completed = 0;
+  for(int i = 0; i < started; i++)
+  {
+    size_t done = load[i].number_of_queries - load[i].failed;
+    memmove(latencies + completed, load[i].latencies, done * sizeof(double));
+    completed += done;
+  }
+
+  if(!completed)
+  {
+    fprintf(stderr, "No queries completed\n");
+    return 1;
+  }
+
+  qsort(latencies, completed, sizeof(double), compareLatency);
+
+  printf("%zu queries from %d clients in %.3fs: %.0f queries/sec\n",
+    completed, started, seconds, completed / seconds);
+  printf("latency (us)  p50: %.1f  p90: %.1f  p99: %.1f  p99.9: %.1f  max: %.1f\n",
+    percentile(latencies, completed, 0.50), percentile(latencies, completed, 0.90),
+    percentile(latencies, completed, 0.99), percentile(latencies, completed, 0.999),
+    latencies[completed - 1]);
+
+  free(threads);
+  free(load);
+  free(latencies);
+
+  return completed == total ? 0 : 1;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+#include "mapindex.h"
+
+/* MAP QUERY PROTOCOL
+  Fixed size binary messages over a Unix domain socket, in host byte order
+  since both ends are always on the same machine. A client writes requests
+  and reads one response per request, in order, on the same connection.
+
+  Every response starts with a MapResponse header:
+
+    MAP_OP_BOX       args = lat0, lon0, lat1, lon1, limit = max nodes (0 = server max)
+                     -> count MapRecords
+    MAP_OP_NEAREST   args = lat, lon, limit = k (at most MAP_MAX_NEAREST)
+                     -> count MapRecords, nearest first by projected distance,
+                        then count floats (great circle miles, as MAP_OP_DISTANCE)
+    MAP_OP_DISTANCE  args = lat0, lon0, lat1, lon1
+                     -> values[0] = great circle miles, count = 0
+    MAP_OP_INFO      -> count = nodes loaded, values = min lat, min lon, max lat, max lon */
+
+#define MAP_SOCKET_PATH "/tmp/mapserver.sock"
+
+#define MAP_MAX_RESULTS 65536
+#define MAP_MAX_NEAREST 64
+
+enum MapOp {
+  MAP_OP_BOX = 1,
+  MAP_OP_NEAREST = 2,
+  MAP_OP_DISTANCE = 3,
+  MAP_OP_INFO = 4
+};
+
+enum MapStatus {
+  MAP_STATUS_OK = 0,
+  MAP_STATUS_BAD_REQUEST = 1, // unknown op, or a lat/lon that is not finite or out of range
+  MAP_STATUS_TRUNCATED = 2 // a box held more than the limit, the first limit nodes were sent
+};
+
+typedef struct MapRequest {
+  uint32_t op;
+  uint32_t limit;
+  float args[4];
+} MapRequest;
+
+typedef struct MapResponse {
+  uint32_t status;
+  uint32_t count;
+  float values[4];
+} MapResponse;
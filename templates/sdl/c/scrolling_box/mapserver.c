@@ -0,0 +1,481 @@
+#define _GNU_SOURCE // accept4
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/uio.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include "arena.h"
+#include "mapdata.h"
+#include "mapindex.h"
+#include "mapproto.h"
+
+/* Headless map query server
+
+  Loads the nodes file once, builds a grid index over it and answers
+  MapRequests (see mapproto.h) on a Unix domain socket. The map and index
+  are read-only after startup, so any number of workers query them without
+  locks. Every worker waits on the same epoll set. Sockets are registered
+  one-shot, so a connection is only ever handled by one worker at a time.
+  Responses are written with writev straight out of the index's record
+  array, so node data is never copied per query.
+
+  Sockets never block a worker. When a client reads slowly and its socket
+  buffer fills, the connection remembers how many bytes of the response
+  went out and is re-armed for EPOLLOUT. The next wake rebuilds the same
+  response from the stored request, which is deterministic since the map
+  never changes, and carries on from that byte. */
+
+#define DEFAULT_WORKERS 4
+
+// a client that keeps a worker busy is put back in line after this many requests
+#define MAX_REQUESTS_PER_WAKE 32
+
+#define MAX_IOV 1024
+
+typedef struct MapServer {
+  MapIndex *index;
+  int listen_fd, epoll_fd, stop_fd;
+  unsigned long queries;
+} MapServer;
+
+typedef struct Connection {
+  int fd;
+  size_t have; // bytes of request read so far
+  MapRequest request;
+  bool pending; // the response to request is only partly written
+  size_t sent;  // bytes of that response already written
+} Connection;
+
+typedef enum SendResult {
+  SEND_DONE,
+  SEND_BLOCKED, // socket buffer full, wait for EPOLLOUT
+  SEND_FAILED
+} SendResult;
+
+// per worker, so the query path never touches the heap
+typedef struct WorkerScratch {
+  MapRun *runs;
+  struct iovec *iov;
+  uint32_t nearest[MAP_MAX_NEAREST];
+  float miles[MAP_MAX_NEAREST];
+} WorkerScratch;
+
+static int stop_fd = -1;
+
+static void handleSignal(int sig)
+{
+  uint64_t one = 1;
+  if(write(stop_fd, &one, sizeof(one)) < 0) {}
+}
+
+static bool rearm(int fd, uint32_t events, void *ptr, int epoll_fd)
+{
+  struct epoll_event ev;
+  ev.events = events | EPOLLONESHOT;
+  ev.data.ptr = ptr;
+  return epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+/* Writes the part of a response described by iov, at most MAX_IOV at a time.
+  *offset is where iov starts within the whole response and is moved past
+  it. Bytes a previous wake already sent (conn->sent) are skipped. */
+static SendResult sendPart(struct iovec *iov, size_t iovcnt, size_t *offset, Connection *conn)
+{
+  size_t len = 0;
+  for(size_t i = 0; i < iovcnt; i++) len += iov[i].iov_len;
+
+  size_t skip = conn->sent > *offset ? conn->sent - *offset : 0;
+  *offset += len;
+  if(skip >= len) return SEND_DONE;
+
+  while(iovcnt && skip >= iov->iov_len)
+  {
+    skip -= iov->iov_len;
+    iov++;
+    iovcnt--;
+  }
+  iov->iov_base = (char *)iov->iov_base + skip;
+  iov->iov_len -= skip;
+
+  while(iovcnt)
+  {
+    ssize_t sent = writev(conn->fd, iov, iovcnt < MAX_IOV ? iovcnt : MAX_IOV);
+    if(sent < 0)
+    {
+      if(errno == EINTR) continue;
+      return errno == EAGAIN || errno == EWOULDBLOCK ? SEND_BLOCKED : SEND_FAILED;
+    }
+    conn->sent += sent;
+
+    while(iovcnt && (size_t)sent >= iov->iov_len)
+    {
+      sent -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+    if(iovcnt)
+    {
+      iov->iov_base = (char *)iov->iov_base + sent;
+      iov->iov_len -= sent;
+    }
+  }
+
+  return SEND_DONE;
+}
+
+static bool validLatLon(float lat, float lon)
+{
+  return isfinite(lat) && isfinite(lon) && fabsf(lat) <= 90.0f && fabsf(lon) <= 180.0f;
+}
+
+// builds the response to conn->request and sends whatever of it is still unsent
+static SendResult answer(Connection *conn, WorkerScratch *scratch, MapServer *server)
+{
+  MapRequest *req = &conn->request;
+  MapIndex *index = server->index;
+  size_t offset = 0;
+  SendResult result;
+  MapResponse header;
+  memset(&header, 0, sizeof(header));
+
+  struct iovec *iov = scratch->iov;
+  iov[0].iov_base = &header;
+  iov[0].iov_len = sizeof(header);
+  size_t iovcnt = 1;
+
+  switch(req->op)
+  {
+    case MAP_OP_BOX:
+    {
+      if(!validLatLon(req->args[0], req->args[1]) || !validLatLon(req->args[2], req->args[3]))
+      {
+        header.status = MAP_STATUS_BAD_REQUEST;
+        break;
+      }
+
+      size_t limit = req->limit && req->limit < MAP_MAX_RESULTS ? req->limit : MAP_MAX_RESULTS;
+      size_t found;
+
+      // ask for one more than allowed to learn whether the box was cut short
+      size_t number_of_runs = queryBox(req->args[0], req->args[1], req->args[2], req->args[3],
+        scratch->runs, limit + 1, &found, index);
+
+      if(found > limit)
+      {
+        if(!--scratch->runs[number_of_runs - 1].count) number_of_runs--;
+        found = limit;
+        header.status = MAP_STATUS_TRUNCATED;
+      }
+
+      header.count = found;
+      if((result = sendPart(iov, iovcnt, &offset, conn)) != SEND_DONE) return result;
+
+      // the runs are sent in batches since there can be more than MAX_IOV of them
+      for(size_t r = 0; r < number_of_runs; r += MAX_IOV)
+      {
+        size_t batch = number_of_runs - r < MAX_IOV ? number_of_runs - r : MAX_IOV;
+        for(size_t i = 0; i < batch; i++)
+        {
+          MapRun *run = &scratch->runs[r + i];
+          iov[i].iov_base = &index->records[run->first];
+          iov[i].iov_len = run->count * sizeof(MapRecord);
+        }
+        if((result = sendPart(iov, batch, &offset, conn)) != SEND_DONE) return result;
+      }
+      return SEND_DONE;
+    }
+
+    case MAP_OP_NEAREST:
+    {
+      if(!validLatLon(req->args[0], req->args[1]))
+      {
+        header.status = MAP_STATUS_BAD_REQUEST;
+        break;
+      }
+
+      size_t k = req->limit < MAP_MAX_NEAREST ? req->limit : MAP_MAX_NEAREST;
+      size_t found = queryNearest(req->args[0], req->args[1], k, scratch->nearest, scratch->miles, index);
+
+      header.count = found;
+      for(size_t i = 0; i < found; i++)
+      {
+        iov[iovcnt].iov_base = &index->records[scratch->nearest[i]];
+        iov[iovcnt].iov_len = sizeof(MapRecord);
+        iovcnt++;
+      }
+      iov[iovcnt].iov_base = scratch->miles;
+      iov[iovcnt].iov_len = found * sizeof(float);
+      iovcnt++;
+      break;
+    }
+
+    case MAP_OP_DISTANCE:
+      if(!validLatLon(req->args[0], req->args[1]) || !validLatLon(req->args[2], req->args[3]))
+      {
+        header.status = MAP_STATUS_BAD_REQUEST;
+        break;
+      }
+      header.values[0] = distanceMiles(req->args[0], req->args[1], req->args[2], req->args[3]);
+      break;
+
+    case MAP_OP_INFO:
+      header.count = index->number_of_records;
+      header.values[0] = index->min_lat;
+      header.values[1] = index->min_lon;
+      header.values[2] = index->max_lat;
+      header.values[3] = index->max_lon;
+      break;
+
+    default:
+      header.status = MAP_STATUS_BAD_REQUEST;
+      break;
+  }
+
+  return sendPart(iov, iovcnt, &offset, conn);
+}
+
+// false once the connection should be closed, otherwise conn->pending says what to wait for
+static bool serveConnection(Connection *conn, WorkerScratch *scratch, MapServer *server)
+{
+  for(int served = 0; served < MAX_REQUESTS_PER_WAKE; )
+  {
+    if(!conn->pending)
+    {
+      ssize_t got = read(conn->fd, (char *)&conn->request + conn->have, sizeof(MapRequest) - conn->have);
+      if(got == 0) return false;
+      if(got < 0)
+      {
+        if(errno == EINTR) continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+      }
+
+      conn->have += got;
+      if(conn->have < sizeof(MapRequest)) continue;
+      conn->have = 0;
+      conn->pending = true;
+      conn->sent = 0;
+    }
+
+    SendResult result = answer(conn, scratch, server);
+    if(result == SEND_FAILED) return false;
+    if(result == SEND_BLOCKED) return true;
+
+    conn->pending = false;
+    __atomic_add_fetch(&server->queries, 1, __ATOMIC_RELAXED);
+    served++;
+  }
+
+  return true;
+}
+
+static void acceptClients(MapServer *server)
+{
+  while(true)
+  {
+    int fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if(fd < 0)
+    {
+      if(errno == EINTR) continue;
+      if(errno != EAGAIN && errno != EWOULDBLOCK) perror("accept4");
+      return;
+    }
+
+    Connection *conn = malloc(sizeof(Connection));
+    if(!conn)
+    {
+      close(fd);
+      continue;
+    }
+    conn->fd = fd;
+    conn->have = 0;
+    conn->pending = false;
+    conn->sent = 0;
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    ev.data.ptr = conn;
+    if(epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0)
+    {
+      perror("epoll_ctl");
+      close(fd);
+      free(conn);
+    }
+  }
+}
+
+static void *serveQueries(void *data)
+{
+  MapServer *server = data;
+
+  Arena *arena = createArena((MAP_MAX_RESULTS + 1) * sizeof(MapRun) + MAX_IOV * sizeof(struct iovec)
+    + sizeof(WorkerScratch) + 3 * ARENA_ALIGN);
+  if(!arena) return NULL;
+
+  WorkerScratch *scratch = arenaAlloc(sizeof(WorkerScratch), arena);
+  scratch->runs = arenaAlloc((MAP_MAX_RESULTS + 1) * sizeof(MapRun), arena);
+  scratch->iov = arenaAlloc(MAX_IOV * sizeof(struct iovec), arena);
+
+  while(true)
+  {
+    struct epoll_event ev;
+    int n = epoll_wait(server->epoll_fd, &ev, 1, -1);
+    if(n < 0)
+    {
+      if(errno == EINTR) continue;
+      perror("epoll_wait");
+      break;
+    }
+
+    // level triggered and never drained, so it wakes every worker
+    if(ev.data.ptr == &server->stop_fd) break;
+
+    if(ev.data.ptr == &server->listen_fd)
+    {
+      acceptClients(server);
+      rearm(server->listen_fd, EPOLLIN, &server->listen_fd, server->epoll_fd);
+      continue;
+    }
+
+    Connection *conn = ev.data.ptr;
+    if(!serveConnection(conn, scratch, server)
+      || !rearm(conn->fd, conn->pending ? EPOLLOUT : EPOLLIN, conn, server->epoll_fd))
+    {
+      close(conn->fd);
+      free(conn);
+    }
+  }
+
+  destroyArena(arena);
+  return NULL;
+}
+
+static int listenOn(const char socket_path[])
+{
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if(strlen(socket_path) >= sizeof(addr.sun_path))
+  {
+    fprintf(stderr, "Socket path too long: %s\n", socket_path);
+    return -1;
+  }
+  strcpy(addr.sun_path, socket_path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if(fd < 0)
+  {
+    perror("socket");
+    return -1;
+  }
+
+  unlink(socket_path);
+  if(bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0)
+  {
+    perror(socket_path);
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+int main(int argc, char **argv)
+{
+  if(argc < 2)
+  {
+    fprintf(stderr, "usage: %s <nodes file> [workers] [socket path]\n", argv[0]);
+    return 1;
+  }
+
+  const char *nodes_filename = argv[1];
+  int workers = argc > 2 ? atoi(argv[2]) : DEFAULT_WORKERS;
+  const char *socket_path = argc > 3 ? argv[3] : MAP_SOCKET_PATH;
+  if(workers < 1) workers = 1;
+
+  FILE* nodes_file = fopen(nodes_filename, "r");
+  if(!nodes_file)
+  {
+    fprintf(stderr, "Failed to open file: %s\n", nodes_filename);
+    return 1;
+  }
+  size_t capacity = countLines(nodes_file);
+  fclose(nodes_file);
+
+  // the map and its index share one arena, sized from the file up front
+  Arena *arena = createArena(mapDataSize(capacity) + mapIndexSize(capacity));
+  if(!arena) return 1;
+
+  MapData *map = loadMapData(nodes_filename, capacity, arena);
+  MapIndex *index = map ? createMapIndex(map, arena) : NULL;
+  if(!index)
+  {
+    destroyArena(arena);
+    return 1;
+  }
+
+  MapServer server;
+  server.index = index;
+  server.queries = 0;
+  server.listen_fd = listenOn(socket_path);
+  server.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  server.stop_fd = stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if(server.listen_fd < 0 || server.epoll_fd < 0 || server.stop_fd < 0)
+  {
+    if(server.epoll_fd < 0 || server.stop_fd < 0) perror("epoll/eventfd");
+    destroyArena(arena);
+    return 1;
+  }
+
+  struct epoll_event ev;
+  ev.events = EPOLLIN;
+  ev.data.ptr = &server.stop_fd;
+  epoll_ctl(server.epoll_fd, EPOLL_CTL_ADD, server.stop_fd, &ev);
+  ev.events = EPOLLIN | EPOLLONESHOT;
+  ev.data.ptr = &server.listen_fd;
+  epoll_ctl(server.epoll_fd, EPOLL_CTL_ADD, server.listen_fd, &ev);
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = handleSignal;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  printf("Serving %zu nodes on %s with %d workers (%d x %d cells)\n",
+    index->number_of_records, socket_path, workers, index->cells_x, index->cells_y);
+
+  pthread_t *threads = malloc(workers * sizeof(pthread_t));
+  int started = 0;
+  for(int i = 0; i < workers; i++)
+  {
+    if(pthread_create(&threads[started], NULL, serveQueries, &server) != 0)
+      fprintf(stderr, "pthread_create FAILED\n");
+    else started++;
+  }
+
+  if(!started) serveQueries(&server);
+
+  for(int i = 0; i < started; i++)
+    pthread_join(threads[i], NULL);
+
+  printf("\nServed %lu queries\n", server.queries);
+
+  free(threads);
+  close(server.listen_fd);
+  close(server.epoll_fd);
+  close(server.stop_fd);
+  unlink(socket_path);
+  destroyArena(arena);
+
+  return 0;
+}
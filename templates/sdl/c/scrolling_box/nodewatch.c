@@ -0,0 +1,80 @@
+#include "nodewatch.h"
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The directory is watched rather than the file itself because most editors
+  save by writing a new file and renaming it over the old one, which would
+  silently drop a watch on the original inode. */
+
+NodeWatch *createNodeWatch(const char nodes_filename[])
+{
+  if(strlen(nodes_filename) >= NODE_WATCH_PATH_MAX)
+  {
+    fprintf(stderr, "Path too long to watch: %s\n", nodes_filename);
+    return NULL;
+  }
+
+  NodeWatch *nw = malloc(sizeof(NodeWatch));
+  if(!nw) return NULL;
+
+  const char *slash = strrchr(nodes_filename, '/');
+  if(slash)
+  {
+    snprintf(nw->dirname, NODE_WATCH_PATH_MAX, "%.*s", (int)(slash - nodes_filename), nodes_filename);
+    if(!nw->dirname[0]) strcpy(nw->dirname, "/");
+    strcpy(nw->basename, slash + 1);
+  }
+  else
+  {
+    strcpy(nw->dirname, ".");
+    strcpy(nw->basename, nodes_filename);
+  }
+
+  nw->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if(nw->fd < 0)
+  {
+    perror("inotify_init1");
+    free(nw);
+    return NULL;
+  }
+
+  nw->wd = inotify_add_watch(nw->fd, nw->dirname, IN_CLOSE_WRITE | IN_MOVED_TO);
+  if(nw->wd < 0)
+  {
+    perror("inotify_add_watch");
+    close(nw->fd);
+    free(nw);
+    return NULL;
+  }
+
+  return nw;
+}
+
+void destroyNodeWatch(NodeWatch *nw)
+{
+  if(nw->wd >= 0) inotify_rm_watch(nw->fd, nw->wd);
+  if(nw->fd >= 0) close(nw->fd);
+  free(nw);
+}
+
+// Never blocks, so it is safe to call once per frame
+bool nodesFileChanged(NodeWatch *nw)
+{
+  char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+  bool changed = false;
+  ssize_t len;
+
+  while((len = read(nw->fd, buf, sizeof(buf))) > 0)
+  {
+    for(char *ptr = buf; ptr < buf + len; ptr += sizeof(struct inotify_event) + ((struct inotify_event *)ptr)->len)
+    {
+      const struct inotify_event *event = (const struct inotify_event *)ptr;
+      if(event->len && strcmp(event->name, nw->basename) == 0) changed = true;
+    }
+  }
+
+  return changed;
+}
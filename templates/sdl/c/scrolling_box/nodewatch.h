@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdbool.h>
+
+#define NODE_WATCH_PATH_MAX 256
+
+typedef struct NodeWatch {
+  int fd, wd;
+  char dirname[NODE_WATCH_PATH_MAX];
+  char basename[NODE_WATCH_PATH_MAX];
+} NodeWatch;
+
+NodeWatch *createNodeWatch(const char nodes_filename[]);
+void destroyNodeWatch(NodeWatch *nw);
+
+bool nodesFileChanged(NodeWatch *nw);
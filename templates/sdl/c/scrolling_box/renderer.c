@@ -33,11 +33,41 @@ Renderer *createRenderer(uint32_t w, uint32_t h)
   ren->window_width = w;
   ren->window_height = h;
   ren->ttf = false;
+  ren->font = NULL;
+  ren->font_size = 0;
+  ren->text_texture = NULL;
+  ren->text[0] = '\0';
+  return ren;
+}
+
+// Offscreen software rendering, no window or video subsystem needed
+Renderer *createSurfaceRenderer(SDL_Surface *surface)
+{
+  SDL_Renderer *sdl_renderer = SDL_CreateSoftwareRenderer(surface);
+
+  if(!sdl_renderer)
+  {
+    fprintf(stderr, "SDL_CreateSoftwareRenderer FAILED: %s\n", SDL_GetError());
+    return NULL;
+  }
+
+  Renderer *ren = malloc(sizeof(Renderer));
+  ren->renderer = sdl_renderer;
+  ren->window = NULL;
+  ren->window_width = surface->w;
+  ren->window_height = surface->h;
+  ren->ttf = false;
+  ren->font = NULL;
+  ren->font_size = 0;
+  ren->text_texture = NULL;
+  ren->text[0] = '\0';
   return ren;
 }
 
 void destroyRenderer(Renderer *ren)
 {
+  if(ren->text_texture) SDL_DestroyTexture(ren->text_texture);
+  if(ren->font)     TTF_CloseFont(ren->font);
   if(ren->window)   SDL_DestroyWindow(ren->window);
   if(ren->renderer) SDL_DestroyRenderer(ren->renderer);
   if(ren->ttf)      TTF_Quit();
@@ -77,9 +107,23 @@ void drawLine(SDL_FPoint *start, SDL_FPoint *end, SDL_FPoint *view, float pixels
   SDL_RenderDrawLine(ren->renderer, startPixel.x, startPixel.y, endPixel.x, endPixel.y);
 }
 
+static bool sameText(const char text[], SDL_Color text_color, int text_size, Renderer *ren)
+{
+  return ren->text_texture && ren->font_size == text_size
+    && ren->text_color.r == text_color.r && ren->text_color.g == text_color.g
+    && ren->text_color.b == text_color.b && ren->text_color.a == text_color.a
+    && strcmp(ren->text, text) == 0;
+}
+
 // TODO: take param for custom fonts
 void drawText(const char text[], SDL_Color text_color, int text_size, Renderer *ren)
 {
+  if(sameText(text, text_color, text_size, ren))
+  {
+    SDL_RenderCopy(ren->renderer, ren->text_texture, NULL, &ren->text_rect);
+    return;
+  }
+
   if(!ren->ttf)
   {
     if(TTF_Init() < 0)
@@ -90,17 +134,26 @@ void drawText(const char text[], SDL_Color text_color, int text_size, Renderer *
     else ren->ttf = true;
   }
 
-  const char font_file[] = "ttf/IBMPlexMono/IBMPlexMono-Regular.ttf";
-  TTF_Font *font = TTF_OpenFont(font_file, text_size);
-
-  if(!font)
+  if(!ren->font || ren->font_size != text_size)
   {
-    fprintf(stderr, "TTF_OpenFont(%s, %d) FAILED\n", font_file, text_size);
-    return;
+    if(ren->font) TTF_CloseFont(ren->font);
+    ren->font_size = 0;
+
+    const char font_file[] = "ttf/IBMPlexMono/IBMPlexMono-Regular.ttf";
+    ren->font = TTF_OpenFont(font_file, text_size);
+
+    if(!ren->font)
+    {
+      fprintf(stderr, "TTF_OpenFont(%s, %d) FAILED\n", font_file, text_size);
+      return;
+    }
+    ren->font_size = text_size;
   }
 
-  SDL_Surface *text_surface = TTF_RenderText_Blended(font, text, text_color);
-  TTF_CloseFont(font);
+  if(ren->text_texture) SDL_DestroyTexture(ren->text_texture);
+  ren->text_texture = NULL;
+
+  SDL_Surface *text_surface = TTF_RenderText_Blended(ren->font, text, text_color);
 
   if(!text_surface)
   {
@@ -108,23 +161,26 @@ void drawText(const char text[], SDL_Color text_color, int text_size, Renderer *
     return;
   }
 
-  SDL_Texture *text_texture = SDL_CreateTextureFromSurface(ren->renderer, text_surface);
+  ren->text_rect.x = (ren->window_width  - text_surface->w) / 2;
+  ren->text_rect.y = (ren->window_height - text_surface->h) / 2;
+  ren->text_rect.w = text_surface->w;
+  ren->text_rect.h = text_surface->h;
+
+  ren->text_texture = SDL_CreateTextureFromSurface(ren->renderer, text_surface);
   SDL_FreeSurface(text_surface);
 
-  if(!text_texture)
+  if(!ren->text_texture)
   {
     fprintf(stderr, "SDL_CreateTextureFromSurface() FAILED: %s\n", SDL_GetError());
     return;
   }
 
-  SDL_Rect text_rect;
-  text_rect.x = (ren->window_width  - text_surface->w) / 2;
-  text_rect.y = (ren->window_height - text_surface->h) / 2;
-  text_rect.w = text_surface->w;
-  text_rect.h = text_surface->h;
+  // text too long to remember is simply redrawn every time
+  if(strlen(text) < MAX_TEXT_LENGTH) strcpy(ren->text, text);
+  else ren->text[0] = '\0';
+  ren->text_color = text_color;
 
-  SDL_RenderCopy(ren->renderer, text_texture, NULL, &text_rect);
-  SDL_DestroyTexture(text_texture);
+  SDL_RenderCopy(ren->renderer, ren->text_texture, NULL, &ren->text_rect);
 }
 
 void display(Renderer* ren)
@@ -2,14 +2,25 @@
 
 #include <SDL2/SDL.h>
 
+#define MAX_TEXT_LENGTH 128
+
 typedef struct Renderer {
   uint32_t window_width, window_height;
   SDL_Window *window;
   SDL_Renderer *renderer;
   bool ttf;
+
+  // drawText keeps its font and last rendered text so unchanged text costs one copy
+  struct _TTF_Font *font;
+  int font_size;
+  SDL_Texture *text_texture;
+  SDL_Rect text_rect;
+  SDL_Color text_color;
+  char text[MAX_TEXT_LENGTH];
 } Renderer;
 
 Renderer *createRenderer(uint32_t w, uint32_t h);
+Renderer *createSurfaceRenderer(SDL_Surface *surface);
 void destroyRenderer(Renderer *ren);
 
 void setRenderDrawColor(uint8_t r, uint8_t g, uint8_t b, Renderer *ren);
@@ -1,58 +1,14 @@
 #include "scrollmap.h"
 #include <stdio.h>
-#include <math.h>
-
-// radius of earth in miles
-#define RADIUS_EARTH 3958.8
-
-float rad(float deg) { return (deg * M_PI) / 180.0f; }
-
-/* SIMPLE EQUIRECTANGULAR PROJECTION
-  x = radius_earth * longitude * cos( average latitude )
-  y = radius_earth * latitude
-  ( latitude and longitude must be converted to radians ) */
-
-void latLonToPt(float lat, float lon, SDL_FPoint *p, float aspect_ratio)
-{
-  p->x = RADIUS_EARTH * rad(lon) * aspect_ratio;
-  p->y = RADIUS_EARTH * rad(lat) * -1.0f;
-}
-
-// TODO: error check ... and eventually make more flexible
-void loadNodesFromFile(FILE* nodes_file, ScrollMap* sm)
-{
-  SDL_FPoint lat_lon_pairs[MAX_MAP_NODES];
-  float sum_of_lats = 0.0f;
-  char* line = NULL;
-  size_t len = 0;
-
-  while( getline(&line, &len, nodes_file) != -1)
-  {
-    printf("%s", line);
-    char * token = strtok(line," ,\n");
-    float lat = atof(token);
-    token = strtok(NULL, " ,\n");
-    float lon = atof(token);
-    lat_lon_pairs[sm->number_of_nodes].x = lat;
-    lat_lon_pairs[sm->number_of_nodes].y = lon;
-    sum_of_lats += lat;
-    sm->number_of_nodes++;
-  }
-
-  free(line);
-
-  float avg_lat = sum_of_lats / sm->number_of_nodes;
-  float aspect_ratio = cos( rad(avg_lat) );
-
-  // convert lat lon pairs to 2D points
-  for(int i = 0; i < sm->number_of_nodes; i++)
-    latLonToPt(lat_lon_pairs[i].x, lat_lon_pairs[i].y, &sm->nodes[i], aspect_ratio);
-}
 
 void centerViewport(Viewport *vw, ScrollMap *sm, int w, int h, float base_ppu)
 {
+  SDL_FPoint start_nodes[4];
+  int n = sm->map->number_of_nodes < 4 ? sm->map->number_of_nodes : 4;
+  for(int i = 0; i < n; i++) start_nodes[i] = nodeAt(i, sm);
+
   SDL_FRect start_box;
-  SDL_EncloseFPoints(sm->nodes, 4, NULL, &start_box);
+  SDL_EncloseFPoints(start_nodes, n, NULL, &start_box);
  
   // THE W/H ARE OFF BY ONE DUE TO A BUG IN EncloseFPoints
   start_box.w -= 1;
@@ -80,37 +36,38 @@ void centerViewport(Viewport *vw, ScrollMap *sm, int w, int h, float base_ppu)
 
 ScrollMap *createScrollMap(uint32_t w, uint32_t h, float base_ppu, const char nodes_filename[])
 {
+  Arena *arena = createArena(SCROLLMAP_ARENA_SIZE);
+  if(!arena) return NULL;
 
-  Viewport *vw = createViewport(w, h, base_ppu);
-  if(!vw) return NULL; // TODO: error message?
-
-  ScrollMap *sm = malloc(sizeof(ScrollMap));
-  if(!sm)
+  ScrollMap *sm = arenaAlloc(sizeof(ScrollMap), arena);
+  Viewport *vw = createViewport(w, h, base_ppu, arena);
+  if(!sm || !vw)
   {
-    // TODO: error message?
-    destroyViewport(vw);
+    destroyArena(arena);
     return NULL;
   }
 
-  FILE* nodes_file = fopen(nodes_filename, "r");
-  if (!nodes_file)
+  sm->arena = arena;
+  sm->vw = vw;
+
+  sm->map = loadMapData(nodes_filename, MAX_MAP_NODES, arena);
+  if(!sm->map)
   {
-    destroyViewport(vw);
-    destroyScrollMap(sm);
-    fprintf(stderr, "Failed to open file: %s\n", nodes_filename);
+    destroyArena(arena);
     return NULL;
   }
 
-  loadNodesFromFile(nodes_file, sm);
-  fclose(nodes_file);
-
   centerViewport(vw, sm, w, h, base_ppu);
-  sm->vw = vw;
   return sm;
 }
 
+SDL_FPoint nodeAt(int i, ScrollMap *sm)
+{
+  SDL_FPoint p = { sm->map->nodes[i].x, sm->map->nodes[i].y };
+  return p;
+}
+
 void destroyScrollMap(ScrollMap *sm)
 {
-  if(sm->vw) destroyViewport(sm->vw);
-  free(sm);
+  destroyArena(sm->arena);
 }
@@ -2,19 +2,25 @@
 
 #include <SDL2/SDL.h>
 #include "viewport.h"
+#include "arena.h"
+#include "mapdata.h"
 
 #define MAX_MAP_NODES 64
 
+// everything the map loads or derives is carved out of its arena
 typedef struct ScrollMap {
+  Arena *arena;
   Viewport *vw;
-  SDL_FPoint nodes[MAX_MAP_NODES];
-  size_t number_of_nodes;
+  MapData *map;
 } ScrollMap;
 
+// the map, its viewport and its nodes, sized the same way as the server sizes its map
+#define SCROLLMAP_ARENA_SIZE (sizeof(ScrollMap) + sizeof(Viewport) + mapDataSize(MAX_MAP_NODES) + 2 * ARENA_ALIGN)
+
 ScrollMap *createScrollMap(uint32_t w, uint32_t h, float base_ppu, const char nodes_filename[]);
 void destroyScrollMap(ScrollMap *sm);
 
-float rad(float deg);
-void latLonToPt(float lat, float lon, SDL_FPoint *p, float aspect_ratio);
-void loadNodesFromFile(FILE* nodes_file, ScrollMap* sm);
+// node i as an SDL point for drawing
+SDL_FPoint nodeAt(int i, ScrollMap *sm);
+
 void centerViewport(Viewport *vw, ScrollMap *sm, int w, int h, float base_ppu);
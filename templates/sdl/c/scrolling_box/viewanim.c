@@ -0,0 +1,143 @@
+#include "viewanim.h"
+#include <math.h>
+
+/* VIEW ANIMATION
+  Input handlers only record what happened, stepViewAnim applies it once
+  per frame. Every drag event in a frame is summed instead of keeping just
+  the last one, a fling keeps coasting with exponential friction after the
+  button is let go, and wheel steps move a target scale that the view eases
+  toward around the cursor. A step costs the same no matter how many events
+  arrived, so input never holds up a frame. */
+
+// velocity decays by e every 1/FRICTION seconds
+#define FRICTION 4.0f
+// pixels per second below which coasting stops
+#define STOP_SPEED 20.0f
+// only motion this recent (ms) counts toward the release velocity
+#define VELOCITY_WINDOW 80
+// holding still this long (ms) before letting go means no fling
+#define HOLD_TIME 50
+// remaining log-zoom decays by e every 1/ZOOM_RATE seconds
+#define ZOOM_RATE 15.0f
+// scale change per wheel notch
+#define ZOOM_STEP 1.25f
+// long stalls are not turned into big jumps
+#define MAX_DT 0.1f
+
+void initViewAnim(ViewAnim *va, float minScale, float maxScale, Viewport *vw)
+{
+  va->drag.x = va->drag.y = 0.0f;
+  va->velocity.x = va->velocity.y = 0.0f;
+  va->next_sample = va->number_of_samples = 0;
+  va->dragging = va->coasting = false;
+
+  va->target_scale = vw->scale;
+  va->min_scale = minScale;
+  va->max_scale = maxScale;
+  va->zoom_anchor.x = vw->width  / 2.0f;
+  va->zoom_anchor.y = vw->height / 2.0f;
+}
+
+// grabbing the map stops it from coasting
+void animPress(ViewAnim *va)
+{
+  va->dragging = true;
+  va->coasting = false;
+  va->number_of_samples = 0;
+}
+
+void animMotion(ViewAnim *va, int xrel, int yrel, uint32_t timestamp)
+{
+  va->dragging = true;
+  va->coasting = false;
+  va->drag.x += xrel;
+  va->drag.y += yrel;
+
+  MotionSample *s = &va->samples[va->next_sample];
+  s->x = xrel;
+  s->y = yrel;
+  s->timestamp = timestamp;
+  va->next_sample = (va->next_sample + 1) % VIEW_ANIM_SAMPLES;
+  if(va->number_of_samples < VIEW_ANIM_SAMPLES) va->number_of_samples++;
+}
+
+void animRelease(ViewAnim *va, uint32_t timestamp)
+{
+  if(!va->dragging) return;
+  va->dragging = false;
+
+  if(!va->number_of_samples) return;
+
+  int newest = (va->next_sample + VIEW_ANIM_SAMPLES - 1) % VIEW_ANIM_SAMPLES;
+  uint32_t last_time = va->samples[newest].timestamp;
+  if(timestamp - last_time > HOLD_TIME) return;
+
+  // find the oldest sample inside the window, it only marks when the window opened
+  int in_window = 0;
+  uint32_t first_time = last_time;
+  for(int n = 0; n < va->number_of_samples; n++)
+  {
+    MotionSample *s = &va->samples[(newest + VIEW_ANIM_SAMPLES - n) % VIEW_ANIM_SAMPLES];
+    if(last_time - s->timestamp > VELOCITY_WINDOW) break;
+    first_time = s->timestamp;
+    in_window++;
+  }
+
+  // sum the motion of every sample newer than it
+  float sum_x = 0.0f, sum_y = 0.0f;
+  for(int n = 0; n < in_window - 1; n++)
+  {
+    MotionSample *s = &va->samples[(newest + VIEW_ANIM_SAMPLES - n) % VIEW_ANIM_SAMPLES];
+    sum_x += s->x;
+    sum_y += s->y;
+  }
+
+  if(last_time == first_time) return;
+
+  float seconds = (last_time - first_time) / 1000.0f;
+  va->velocity.x = sum_x / seconds;
+  va->velocity.y = sum_y / seconds;
+  va->coasting = true;
+  va->number_of_samples = 0;
+}
+
+void animScroll(ViewAnim *va, float scroll_y, SDL_Point mouse)
+{
+  va->target_scale *= powf(ZOOM_STEP, scroll_y);
+  if(va->target_scale < va->min_scale) va->target_scale = va->min_scale;
+  if(va->target_scale > va->max_scale) va->target_scale = va->max_scale;
+
+  va->zoom_anchor.x = mouse.x;
+  va->zoom_anchor.y = mouse.y;
+}
+
+void stepViewAnim(ViewAnim *va, float dt, Viewport *vw)
+{
+  if(dt > MAX_DT) dt = MAX_DT;
+
+  if(va->drag.x || va->drag.y)
+  {
+    panView(va->drag, vw);
+    va->drag.x = va->drag.y = 0.0f;
+  }
+  else if(va->coasting)
+  {
+    SDL_FPoint motion = { va->velocity.x * dt, va->velocity.y * dt };
+    panView(motion, vw);
+
+    float decay = expf(-FRICTION * dt);
+    va->velocity.x *= decay;
+    va->velocity.y *= decay;
+    if(hypotf(va->velocity.x, va->velocity.y) < STOP_SPEED) va->coasting = false;
+  }
+
+  if(vw->scale != va->target_scale)
+  {
+    float remaining = logf(va->target_scale / vw->scale);
+    float scale = vw->scale * expf(remaining * (1.0f - expf(-ZOOM_RATE * dt)));
+
+    // snap once the difference is too small to see
+    if(fabsf(remaining) < 0.001f) scale = va->target_scale;
+    zoomView(scale, va->zoom_anchor, vw);
+  }
+}
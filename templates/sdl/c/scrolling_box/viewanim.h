@@ -0,0 +1,36 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include "viewport.h"
+
+// covers the 80 ms velocity window of a 1000 Hz mouse with room to spare
+#define VIEW_ANIM_SAMPLES 128
+
+typedef struct MotionSample {
+  float x, y;
+  uint32_t timestamp;
+} MotionSample;
+
+typedef struct ViewAnim {
+
+  // panning, in pixels
+  SDL_FPoint drag, velocity;
+  MotionSample samples[VIEW_ANIM_SAMPLES];
+  int next_sample, number_of_samples;
+  bool dragging, coasting;
+
+  // zooming
+  float target_scale, min_scale, max_scale;
+  SDL_FPoint zoom_anchor;
+
+} ViewAnim;
+
+void initViewAnim(ViewAnim *va, float minScale, float maxScale, Viewport *vw);
+
+void animPress(ViewAnim *va);
+void animMotion(ViewAnim *va, int xrel, int yrel, uint32_t timestamp);
+void animRelease(ViewAnim *va, uint32_t timestamp);
+void animScroll(ViewAnim *va, float scroll_y, SDL_Point mouse);
+
+void stepViewAnim(ViewAnim *va, float dt, Viewport *vw);
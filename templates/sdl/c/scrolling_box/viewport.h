@@ -1,6 +1,7 @@
 #pragma once
 
 #include <SDL2/SDL.h>
+#include "arena.h"
 
 typedef struct Viewport {
 
@@ -10,8 +11,8 @@ typedef struct Viewport {
 
 } Viewport;
 
-Viewport *createViewport(uint32_t w, uint32_t h, float base_ppu);
-void destroyViewport(Viewport *vw);
+// lives in the arena, released along with it
+Viewport *createViewport(uint32_t w, uint32_t h, float base_ppu, Arena *arena);
 
-void handleMotion(SDL_Point motion, Viewport *vw);
-void handleScroll(float scroll_y, SDL_Point mouse, float minScale, float maxScale, Viewport *vw);
+void panView(SDL_FPoint motion, Viewport *vw);
+void zoomView(float scale, SDL_FPoint anchor, Viewport *vw);